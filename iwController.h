@@ -0,0 +1,345 @@
+/*****************************************************************************************
+* Title: 	iwController                                                             *
+* Purpose: 	Closed-loop TX power and bit rate control for iwconfigAPI. Every control *
+*		period each interface is read with a single snapshot command, its link   *
+*		margin (signal level minus the receiver sensitivity of the current rate) *
+*		is compared with the interface's target, and at most one TX power and    *
+*		one bit rate command is issued:                                          *
+*		    - the rate is raised one step when the faster rate would still reach *
+*		      target + hysteresis at maximum TX power (one dB of margin per dB   *
+*		      of power, the reciprocal link assumption power control rests on);  *
+*		    - otherwise, inside target +/- hysteresis nothing is changed;        *
+*		    - below it TX power is raised, by at most the step limit, and once   *
+*		      TX power is at its maximum the rate is lowered one step;           *
+*		    - above it TX power is lowered, by at most the step limit.           *
+*		Power steps are whole dB between 1 and the step limit. Rate changes are  *
+*		held off for a minimum time so that a rate step and the power steps it   *
+*		causes do not oscillate. The loop runs in process at tens of Hz. By      *
+*		default every command, reads included, goes through the backend of the   *
+*		iwconfigAPI object (shell, simulation, replay, recording): one snapshot  *
+*		command per period reads the link. For an iwconfigAPI on the shell       *
+*		backend, reading through nl80211 (no process spawned) can be enabled: a  *
+*		Managed adapter is then read from the station entry of its associated    *
+*		access point, any other one still with the snapshot command. The         *
+*		controller records period, fetch, actuation and loop latency             *
+*		percentiles.                                                             *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include "iwconfigAPI.h"
+#include "iwStation.h"
+#include "iwLatency.h"
+#include<algorithm>
+#include<chrono>
+#include<cmath>
+#include<memory>
+#include<mutex>
+#include<thread>
+#include<unordered_map>
+#include<stdint.h>
+
+/*****************************************************************************************
+* Macros and Constants                                                                   *
+*****************************************************************************************/
+#ifndef _IWCONTROLLER
+#define _IWCONTROLLER
+
+// 802.11a/g OFDM rates (Mb/s) and the receiver sensitivity (dBm) each one needs.
+static const double iwControlRates[] = {6, 9, 12, 18, 24, 36, 48, 54};
+static const double iwControlSensitivity[] = {-82, -81, -79, -77, -74, -70, -66, -65};
+static const int iwControlRateCount = 8;
+
+// Control target of one interface.
+struct iwControlTarget {
+    double margin_db = 10;       // wanted signal level above the sensitivity of the rate
+    double hysteresis_db = 2;    // dead band around the target
+    double max_step_db = 2;      // largest TX power change per control period (at least 1 dB)
+    int min_power_dbm = 0;
+    int max_power_dbm = 20;
+    bool adaptRate = true;       // also move the bit rate along iwControlRates
+    double rate_hold_ms = 500;   // minimum time between two rate changes
+};
+
+// Last observation and command of one interface.
+struct iwControlState {
+    iwStatus status;             // of the last snapshot
+    double signal_dbm;
+    double margin_db;
+    int power_dbm;               // TX power in effect
+    double rate_mbps;            // bit rate in effect
+    uint64_t powerChanges;
+    uint64_t rateChanges;
+};
+
+/*****************************************************************************************
+* Controller                                                                             *
+*****************************************************************************************/
+class iwController
+{
+   public:
+	struct statistics {
+	    uint64_t iterations;  // control periods run
+	    uint64_t overruns;    // periods whose loop took longer than the period
+	    uint64_t skipped;     // periods dropped to catch up after an overrun
+	    uint64_t failures;    // snapshots that did not return iwOK
+	    uint64_t powerChanges;
+	    uint64_t rateChanges;
+	    iwLatencySummary period;   // start to start of consecutive periods
+	    iwLatencySummary fetch;    // one snapshot command
+	    iwLatencySummary actuate;  // one set command
+	    iwLatencySummary loop;     // whole control period, every interface
+	};
+
+   private:
+	struct link {
+	    iwControlTarget target;
+	    iwControlState state;
+	    int rateIndex;
+	    bool known;                          // power and rate read at least once
+	    bool haveBssid = false;              // bssid of the last nl80211 read
+	    uint8_t bssid[6];
+	    std::chrono::steady_clock::time_point lastRateChange;
+	};
+
+	iwconfigAPI & wifiAPI;
+	std::chrono::nanoseconds period;
+	std::mutex stepLock;                          // one control period at a time, held across commands
+	std::mutex lock;                              // links and statistics, never held across a command
+	std::unordered_map<std::string, link> links;
+	std::vector<std::pair<std::string, link>> work; // links of the current period, reused
+	std::unique_ptr<iwNl80211> nl80211;           // NULL unless enabled
+	std::vector<char> dump;                       // reused station dump
+	iwSnapshot snap;                              // reused every read
+	std::chrono::steady_clock::time_point lastStart;
+	uint64_t iterations, overruns, skipped, failures, powerChanges, rateChanges;
+	iwLatencyWindow periodTime, fetchTime, actuateTime, loopTime;
+
+	static double microseconds(std::chrono::steady_clock::duration d){
+	    return std::chrono::duration<double, std::micro>(d).count();
+	}
+	// Index of the fastest table rate not above mbps.
+	static int rateIndexOf(double mbps){
+	    int index = 0;
+	    for (int i = 0; i < iwControlRateCount; i++) {
+		if (iwControlRates[i] <= mbps + 1e-6) index = i;
+	    }
+	    return index;
+	}
+
+	// Power step towards an error of the given size: whole dB, at least 1 and at most the limit.
+	static int powerStep(double rounded, double max_step_db){
+	    int limit = std::max(1, (int)std::floor(max_step_db));
+	    return std::max(1, std::min(limit, (int)rounded));
+	}
+
+/*****************************************************************************************
+* Read Link: signal, bit rate and TX power of an interface into snap. With nl80211       *
+* enabled, a Managed adapter is read from the station entry of its access point (the     *
+* BSSID is looked up again when the entry is gone, after a roam) and from                *
+* NL80211_CMD_GET_INTERFACE; any other interface with a single snapshot command.         *
+*****************************************************************************************/
+	iwStatus readLink(const std::string & wifi, link & l){
+	    uint32_t iftype;
+	    if (nl80211 && nl80211->getInterface(wifi, iftype, snap.txpower) == iwOK && iftype == NL80211_IFTYPE_STATION
+		&& nl80211->dumpStations(wifi, dump) == iwOK) {
+		iwStation sta;
+		bool found = l.haveBssid && iwFindStation(dump, l.bssid, sta);
+		if (!found) {
+			l.haveBssid = nl80211->getBssid(wifi, l.bssid) == iwOK;
+			found = l.haveBssid && iwFindStation(dump, l.bssid, sta);
+		}
+		if (!found) snap.signal = iwResult<double>{iwNotFound, -174};
+		else snap.signal = iwResult<double>{iwOK, (double)(sta.signal ? sta.signal : sta.signalAvg)};
+		snap.bitrate = iwResult<double>{found && sta.txBitrate > 0 ? iwOK : iwNotFound, sta.txBitrate};
+		return iwOK;
+	    }
+	    return wifiAPI.tryGetSnapshot(wifi, snap);
+	}
+
+/*****************************************************************************************
+* Control: one period of one interface, on a copy of its link. Called with stepLock held *
+* and the controller lock released, so the commands do not block setTarget, getState or  *
+* getStatistics.                                                                         *
+*****************************************************************************************/
+	void control(const std::string & wifi, link & l){
+	    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	    iwStatus status = readLink(wifi, l);
+	    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	    l.state.status = status == iwOK ? snap.signal.status : status;
+	    {
+	    std::lock_guard<std::mutex> guard(lock);
+	    fetchTime.add(microseconds(now - t0));
+	    if (l.state.status != iwOK) failures++;
+	    }
+	    if (l.state.status != iwOK) return;
+	    const iwControlTarget & target = l.target;
+	    // What the driver reports wins over what was commanded, once it is readable.
+	    if (snap.txpower.ok()) l.state.power_dbm = (int)std::lround(snap.txpower.value);
+	    else if (!l.known) l.state.power_dbm = target.max_power_dbm;
+	    if (snap.bitrate.ok()) l.rateIndex = rateIndexOf(snap.bitrate.value);
+	    else if (!l.known) l.rateIndex = iwControlRateCount - 1;
+	    l.known = true;
+	    l.state.rate_mbps = iwControlRates[l.rateIndex];
+	    l.state.signal_dbm = snap.signal.value;
+	    l.state.margin_db = snap.signal.value - iwControlSensitivity[l.rateIndex];
+
+	    double error = l.state.margin_db - target.margin_db;
+	    bool rateFree = target.adaptRate
+		&& std::chrono::duration<double, std::milli>(now - l.lastRateChange).count() >= target.rate_hold_ms;
+	    int power = l.state.power_dbm;
+	    int rate = l.rateIndex;
+	    double headroom = target.max_power_dbm - power;
+	    if (rateFree && rate + 1 < iwControlRateCount
+		&& error - (iwControlSensitivity[rate + 1] - iwControlSensitivity[rate]) + headroom >= target.hysteresis_db)
+		rate++;
+	    else if (std::fabs(error) <= target.hysteresis_db) return;
+	    else if (error < 0) {
+		if (power < target.max_power_dbm) power += powerStep(std::ceil(-error), target.max_step_db);
+		else if (rateFree && rate > 0) rate--;
+	    }
+	    else power -= powerStep(std::floor(error), target.max_step_db);
+	    power = std::max(target.min_power_dbm, std::min(target.max_power_dbm, power));
+
+	    if (power != l.state.power_dbm) {
+		t0 = std::chrono::steady_clock::now();
+		iwStatus set = wifiAPI.setTXPower(wifi, dBm, power);
+		double took = microseconds(std::chrono::steady_clock::now() - t0);
+		std::lock_guard<std::mutex> guard(lock);
+		actuateTime.add(took);
+		if (set == iwOK) {
+			l.state.power_dbm = power;
+			l.state.powerChanges++;
+			powerChanges++;
+		}
+		else failures++;
+	    }
+	    if (rate != l.rateIndex) {
+		t0 = std::chrono::steady_clock::now();
+		iwStatus set = wifiAPI.setBitRate(wifi, iwControlRates[rate], MHz);
+		double took = microseconds(std::chrono::steady_clock::now() - t0);
+		std::lock_guard<std::mutex> guard(lock);
+		actuateTime.add(took);
+		if (set == iwOK) {
+			l.rateIndex = rate;
+			l.state.rate_mbps = iwControlRates[rate];
+			l.lastRateChange = now;
+			l.state.rateChanges++;
+			rateChanges++;
+		}
+		else failures++;
+	    }
+	}
+
+   public:
+	// useNl80211: read Managed adapters through nl80211 instead of iwconfig. Only for an api
+	// on the shell backend: nl80211 reads the host's adapters, whatever the backend is.
+	explicit iwController(iwconfigAPI & api, double rate_hz = 20, bool useNl80211 = false)
+		: wifiAPI(api), iterations(0), overruns(0), skipped(0), failures(0), powerChanges(0), rateChanges(0) {
+	    if (useNl80211) nl80211.reset(new iwNl80211());
+	    setRate(rate_hz);
+	}
+	iwController(const iwController &) = delete;
+	iwController & operator=(const iwController &) = delete;
+
+	// Control periods per second.
+	void setRate(double rate_hz){
+	    std::lock_guard<std::mutex> guard(lock);
+	    period = std::chrono::nanoseconds((int64_t)(1e9 / (rate_hz > 0 ? rate_hz : 1)));
+	}
+
+/*****************************************************************************************
+* Set/Remove Target: start or stop controlling an interface. Setting the target of an    *
+* interface already controlled only changes its target.                                  *
+*****************************************************************************************/
+	void setTarget(const std::string & wifi, const iwControlTarget & target){
+	    std::lock_guard<std::mutex> guard(lock);
+	    std::unordered_map<std::string, link>::iterator it = links.find(wifi);
+	    if (it == links.end()) {
+		link l;
+		l.state = iwControlState{iwNotFound, -174, 0, target.max_power_dbm, 0, 0, 0};
+		l.rateIndex = iwControlRateCount - 1;
+		l.known = false;
+		it = links.emplace(wifi, l).first;
+	    }
+	    it->second.target = target;
+	}
+	void removeTarget(const std::string & wifi){
+	    std::lock_guard<std::mutex> guard(lock);
+	    links.erase(wifi);
+	}
+	bool getState(const std::string & wifi, iwControlState & state){
+	    std::lock_guard<std::mutex> guard(lock);
+	    std::unordered_map<std::string, link>::iterator it = links.find(wifi);
+	    if (it == links.end()) return false;
+	    state = it->second.state;
+	    return true;
+	}
+
+/*****************************************************************************************
+* Step: one control period over every interface. The links are copied under the lock,    *
+* controlled without it and written back, unless removed meanwhile; a target set during  *
+* the period is kept and applies from the next one.                                      *
+*****************************************************************************************/
+	void step(){
+	    std::lock_guard<std::mutex> stepping(stepLock);
+	    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	    size_t count = 0;
+	    {
+	    std::lock_guard<std::mutex> guard(lock);
+	    if (iterations) periodTime.add(microseconds(start - lastStart));
+	    lastStart = start;
+	    if (work.size() < links.size()) work.resize(links.size());
+	    for (std::unordered_map<std::string, link>::iterator it = links.begin(); it != links.end(); ++it, count++) {
+		work[count].first = it->first;
+		work[count].second = it->second;
+	    }
+	    }
+	    for (size_t i = 0; i < count; i++) control(work[i].first, work[i].second);
+	    std::lock_guard<std::mutex> guard(lock);
+	    for (size_t i = 0; i < count; i++) {
+		std::unordered_map<std::string, link>::iterator it = links.find(work[i].first);
+		if (it == links.end()) continue;
+		iwControlTarget target = it->second.target;
+		it->second = work[i].second;
+		it->second.target = target;
+	    }
+	    std::chrono::steady_clock::duration took = std::chrono::steady_clock::now() - start;
+	    loopTime.add(microseconds(took));
+	    if (took > period) overruns++;
+	    iterations++;
+	}
+
+/*****************************************************************************************
+* Run: call step on a drift free grid of control periods until stop is set. Periods      *
+* missed after an overrun are skipped rather than run back to back.                      *
+*****************************************************************************************/
+	void run(const std::atomic<bool> & stop){
+	    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+	    while (!stop.load(std::memory_order_relaxed)) {
+		step();
+		std::chrono::nanoseconds current;
+		{
+		std::lock_guard<std::mutex> guard(lock);
+		current = period;
+		}
+		next += current;
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (now > next) {
+			uint64_t missed = (uint64_t)((now - next) / current) + 1;
+			next += current * missed;
+			std::lock_guard<std::mutex> guard(lock);
+			skipped += missed;
+		}
+		std::this_thread::sleep_until(next);
+	    }
+	}
+
+	statistics getStatistics(){
+	    std::lock_guard<std::mutex> guard(lock);
+	    statistics s = {iterations, overruns, skipped, failures, powerChanges, rateChanges,
+			    periodTime.summary(), fetchTime.summary(), actuateTime.summary(), loopTime.summary()};
+	    return s;
+	}
+};
+#endif
@@ -0,0 +1,80 @@
+/*****************************************************************************************
+* Title: 	iwEvents                                                                 *
+* Purpose: 	Link events of wireless adapters: association with an access point,      *
+* 		disconnection and refused associations. A source publishes them as they  *
+*		happen, so a component waiting for a reassociation is woken by the event *
+*		itself instead of polling the access point with iwgetid.                 *
+*		Sources: iwSimBackend (simulated radios) and iwNl80211Events (the nl80211*
+*		"mlme" multicast group, in iwStation.h next to the socket it reads).     *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include<chrono>
+#include<functional>
+#include<mutex>
+#include<string>
+#include<utility>
+#include<vector>
+#include<stdint.h>
+
+/*****************************************************************************************
+* Macros and Constants                                                                   *
+*****************************************************************************************/
+#ifndef _IWEVENTS
+#define _IWEVENTS
+
+// This enumeration type tells what happened to the link of an adapter.
+enum iwLinkEventType {iwLinkAssociated, iwLinkDisconnected, iwLinkFailed};
+
+struct iwLinkEvent {
+    std::string wifi;                 // adapter/interface name without padding
+    iwLinkEventType type;
+    std::string bssid;                // access point joined, left or refusing the association
+    std::chrono::steady_clock::time_point time; // when the link changed
+};
+
+/*****************************************************************************************
+* Link Event Source: subscribers are called on the source's own thread, one event at a   *
+* time and under the source's subscriber lock, so unsubscribe() returns only once no     *
+* call to the subscriber is in progress. Subscribers must return quickly and must not    *
+* subscribe or unsubscribe from within the callback.                                     *
+*****************************************************************************************/
+class iwLinkEventSource
+{
+   public:
+	typedef std::function<void(const iwLinkEvent &)> subscriber;
+   private:
+	std::mutex subscribersLock;
+	std::vector<std::pair<uint64_t, subscriber>> subscribers;
+	uint64_t nextId;
+
+   protected:
+	void publish(const iwLinkEvent & event){
+	    std::lock_guard<std::mutex> guard(subscribersLock);
+	    for (size_t i = 0; i < subscribers.size(); i++) subscribers[i].second(event);
+	}
+
+   public:
+	iwLinkEventSource() : nextId(1) {}
+	virtual ~iwLinkEventSource() {}
+	iwLinkEventSource(const iwLinkEventSource &) = delete;
+	iwLinkEventSource & operator=(const iwLinkEventSource &) = delete;
+
+	// Returns the id to unsubscribe with.
+	uint64_t subscribe(subscriber callback){
+	    std::lock_guard<std::mutex> guard(subscribersLock);
+	    subscribers.push_back(std::make_pair(nextId, callback));
+	    return nextId++;
+	}
+	void unsubscribe(uint64_t id){
+	    std::lock_guard<std::mutex> guard(subscribersLock);
+	    for (size_t i = 0; i < subscribers.size(); i++) {
+		if (subscribers[i].first == id) {
+			subscribers.erase(subscribers.begin() + i);
+			return;
+		}
+	    }
+	}
+};
+#endif
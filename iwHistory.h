@@ -0,0 +1,419 @@
+/*****************************************************************************************
+* Title: 	iwHistory                                                                *
+* Purpose: 	Compressed in-memory history of adapter metrics. Every (adapter, metric) *
+*		series is a chain of fixed-size blocks encoded as in Facebook's Gorilla: *
+*		    - timestamps are stored as the difference of consecutive deltas, so  *
+*		      a regular sampling interval costs a single bit per sample;         *
+*		    - values are stored as the XOR with the previous value, so a value   *
+*		      that did not change costs a single bit and a small change only its *
+*		      meaningful bits.                                                   *
+*		Blocks keep their time range outside the bit stream, so a window query   *
+*		only decodes the blocks it overlaps. Retention drops whole blocks by age *
+*		or by size, and dropped blocks are reused for new samples. A day of      *
+*		10 Hz samples of a slowly moving metric fits in a few MB instead of the  *
+*		14 MB a (time, value) array would need.                                  *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include "iwconfigAPI.h"
+#include<cstring>
+#include<deque>
+#include<unordered_map>
+#include<stdint.h>
+#include<mutex>
+#include<ostream>
+
+/*****************************************************************************************
+* Macros and Constants                                                                   *
+*****************************************************************************************/
+#ifndef _IWHISTORY
+#define _IWHISTORY
+
+// One decoded sample, time in milliseconds.
+struct iwPoint {
+    int64_t t_ms;
+    double value;
+};
+
+// One downsampled bucket covering [start_ms, start_ms + bucket).
+struct iwBucket {
+    int64_t start_ms;
+    uint32_t count;
+    double min;
+    double max;
+    double mean;
+};
+
+// Memory report over all series.
+struct iwHistoryUsage {
+    size_t series;
+    size_t blocks;
+    uint64_t samples;
+    size_t bytes;        // blocks and series bookkeeping
+    size_t rawBytes;     // the same samples as (int64 time, double value) pairs
+    double bitsPerSample;
+};
+
+/*****************************************************************************************
+* History Block: fixed-size bit stream of Gorilla encoded samples. The first sample is   *
+* kept raw in the header, every following one is appended to the stream.                 *
+*****************************************************************************************/
+class iwHistoryBlock
+{
+   public:
+	static const int words = 120;  // about 1 KiB per block with the header
+	static const int maxSampleBits = 4 + 32 + 2 + 5 + 6 + 64;
+
+	int64_t tFirst, tLast;
+	uint32_t count;
+
+	void reset(){
+	    memset(bits, 0, sizeof(bits));
+	    bitPos = 0;
+	    count = 0;
+	}
+
+	// Appends one sample, returns false when the block is full or the time step does
+	// not fit the encoding; the caller then starts a new block.
+	bool append(int64_t t, double v){
+	    uint64_t value;
+	    memcpy(&value, &v, sizeof(value));
+	    if (count == 0) {
+		tFirst = tLast = t;
+		firstValue = lastValue = value;
+		lastDelta = 0;
+		leading = 65;
+		trailing = 0;
+		count = 1;
+		return true;
+	    }
+	    if (bitPos + maxSampleBits > words * 64) return false;
+	    int64_t delta = t - tLast;
+	    int64_t dod = delta - lastDelta;
+	    if (dod < INT32_MIN || dod > INT32_MAX) return false;
+
+	    // Timestamp: delta of delta with a variable length prefix.
+	    if (dod == 0) put(0, 1);
+	    else if (dod >= -63 && dod <= 64) { put(2, 2); put(dod + 63, 7); }
+	    else if (dod >= -255 && dod <= 256) { put(6, 3); put(dod + 255, 9); }
+	    else if (dod >= -2047 && dod <= 2048) { put(14, 4); put(dod + 2047, 12); }
+	    else { put(15, 4); put((uint32_t)(int32_t)dod, 32); }
+
+	    // Value: XOR with the previous value, reusing the previous window if it fits.
+	    uint64_t x = value ^ lastValue;
+	    if (x == 0) put(0, 1);
+	    else {
+		int lead = __builtin_clzll(x);
+		int trail = __builtin_ctzll(x);
+		if (lead > 31) lead = 31;
+		if (leading <= 64 && lead >= leading && trail >= trailing) {
+		    put(2, 2);
+		    put(x >> trailing, 64 - leading - trailing);
+		}
+		else {
+		    int length = 64 - lead - trail;
+		    put(3, 2);
+		    put(lead, 5);
+		    put(length & 63, 6);  // 64 is stored as 0
+		    put(x >> trail, length);
+		    leading = lead;
+		    trailing = trail;
+		}
+	    }
+	    tLast = t;
+	    lastDelta = delta;
+	    lastValue = value;
+	    count++;
+	    return true;
+	}
+
+	// Decodes the samples in [t0, t1) in time order, returns the number visited.
+	template<typename Visit> size_t decode(int64_t t0, int64_t t1, Visit visit) const {
+	    if (count == 0 || tLast < t0 || tFirst >= t1) return 0;
+	    size_t visited = 0;
+	    size_t pos = 0;
+	    int64_t t = tFirst, delta = 0;
+	    uint64_t value = firstValue;
+	    int lead = 0, trail = 0;
+	    for (uint32_t i = 0; ; i++) {
+		if (t >= t1) break;
+		if (t >= t0) {
+		    double v;
+		    memcpy(&v, &value, sizeof(v));
+		    visit(t, v);
+		    visited++;
+		}
+		if (i + 1 >= count) break;
+
+		int64_t dod;
+		if (get(pos, 1) == 0) dod = 0;
+		else if (get(pos, 1) == 0) dod = (int64_t)get(pos, 7) - 63;
+		else if (get(pos, 1) == 0) dod = (int64_t)get(pos, 9) - 255;
+		else if (get(pos, 1) == 0) dod = (int64_t)get(pos, 12) - 2047;
+		else dod = (int32_t)(uint32_t)get(pos, 32);
+		delta += dod;
+		t += delta;
+
+		if (get(pos, 1) != 0) {
+		    if (get(pos, 1) != 0) {
+			lead = (int)get(pos, 5);
+			int length = (int)get(pos, 6);
+			if (length == 0) length = 64;
+			trail = 64 - lead - length;
+		    }
+		    value ^= get(pos, 64 - lead - trail) << trail;
+		}
+	    }
+	    return visited;
+	}
+
+	size_t usedBits() const { return 64 + 64 + bitPos; }
+
+   private:
+	uint64_t bits[words];
+	uint32_t bitPos;
+	uint64_t firstValue, lastValue;
+	int64_t lastDelta;
+	int leading, trailing;  // current XOR window, leading 65 = none yet
+
+	void put(uint64_t v, int n){
+	    while (n > 0) {
+		int offset = bitPos & 63;
+		int take = std::min(64 - offset, n);
+		uint64_t chunk = (v >> (n - take)) & (take == 64 ? ~0ULL : ((1ULL << take) - 1));
+		bits[bitPos >> 6] |= chunk << (64 - offset - take);
+		bitPos += take;
+		n -= take;
+	    }
+	}
+	uint64_t get(size_t & pos, int n) const {
+	    uint64_t v = 0;
+	    while (n > 0) {
+		int offset = pos & 63;
+		int take = std::min(64 - offset, n);
+		uint64_t chunk = (bits[pos >> 6] >> (64 - offset - take)) & (take == 64 ? ~0ULL : ((1ULL << take) - 1));
+		v = (take == 64) ? chunk : (v << take) | chunk;
+		pos += take;
+		n -= take;
+	    }
+	    return v;
+	}
+};
+
+/*****************************************************************************************
+* History                                                                                *
+*****************************************************************************************/
+class iwHistory
+{
+   private:
+	struct series {
+	    std::mutex lock;
+	    std::deque<std::unique_ptr<iwHistoryBlock>> blocks;
+	    std::unique_ptr<iwHistoryBlock> spare;   // last block dropped by retention
+	    uint64_t samples;
+	    uint64_t rejected;                  // out of order samples
+	};
+
+	int64_t resolution;
+	std::atomic<int64_t> maxAge;      // 0 = keep everything
+	std::atomic<size_t> maxBlocks;    // per series, 0 = unlimited
+	// Series are shared with the append/query calls in progress, so remove() only drops
+	// the table's reference and a series is freed once the last of those calls returns.
+	mutable std::shared_mutex tableLock;
+	std::unordered_map<std::string, std::shared_ptr<series>> table;
+
+	static std::string key(const std::string & wifi, iwMetric metric){
+	    std::string k = wifi;
+	    k.push_back('\0');
+	    k.push_back((char)metric);
+	    return k;
+	}
+	std::shared_ptr<series> find(const std::string & wifi, iwMetric metric) const {
+	    std::shared_lock<std::shared_mutex> guard(tableLock);
+	    std::unordered_map<std::string, std::shared_ptr<series>>::const_iterator it = table.find(key(wifi, metric));
+	    return it == table.end() ? std::shared_ptr<series>() : it->second;
+	}
+	std::shared_ptr<series> findOrAdd(const std::string & wifi, iwMetric metric){
+	    std::shared_ptr<series> s = find(wifi, metric);
+	    if (s) return s;
+	    std::unique_lock<std::shared_mutex> guard(tableLock);
+	    std::shared_ptr<series> & slot = table[key(wifi, metric)];
+	    if (!slot) {
+		slot = std::make_shared<series>();
+		slot->samples = 0;
+		slot->rejected = 0;
+	    }
+	    return slot;
+	}
+	void retain(series & s){
+	    int64_t age = maxAge;
+	    size_t limit = maxBlocks;
+	    while (s.blocks.size() > 1
+		   && ((limit && s.blocks.size() > limit)
+		       || (age && s.blocks.front()->tLast < s.blocks.back()->tLast - age))) {
+		s.samples -= s.blocks.front()->count;
+		s.spare = std::move(s.blocks.front());
+		s.blocks.pop_front();
+	    }
+	}
+	// First block that may hold samples at or after t0.
+	static size_t firstBlock(const series & s, int64_t t0){
+	    size_t lo = 0, hi = s.blocks.size();
+	    while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		if (s.blocks[mid]->tLast < t0) lo = mid + 1;
+		else hi = mid;
+	    }
+	    return lo;
+	}
+	template<typename Visit> size_t decode(const series & s, int64_t t0, int64_t t1, Visit visit) const {
+	    size_t visited = 0;
+	    for (size_t b = firstBlock(s, t0); b < s.blocks.size() && s.blocks[b]->tFirst < t1; b++)
+		visited += s.blocks[b]->decode(t0, t1, visit);
+	    return visited;
+	}
+
+   public:
+	// resolution_ms quantizes timestamps: at 10 Hz, a 100 ms resolution turns polling
+	// jitter into a constant interval and one bit per timestamp.
+	explicit iwHistory(int64_t resolution_ms = 1){
+	    resolution = resolution_ms > 0 ? resolution_ms : 1;
+	    maxAge = 0;
+	    maxBlocks = 0;
+	}
+	iwHistory(const iwHistory &) = delete;
+	iwHistory & operator=(const iwHistory &) = delete;
+
+/*****************************************************************************************
+* Retention: samples older than maxAge_ms behind the newest one, and blocks beyond       *
+* maxBytes per series, are dropped a whole block at a time. 0 disables a limit.          *
+*****************************************************************************************/
+	void setRetention(int64_t maxAge_ms, size_t maxBytes = 0){
+	    maxAge = maxAge_ms > 0 ? maxAge_ms : 0;
+	    maxBlocks = maxBytes ? std::max((size_t)1, maxBytes / sizeof(iwHistoryBlock)) : 0;
+	}
+
+/*****************************************************************************************
+* Append: adds one sample to a series. Samples older than the last one of the series     *
+* are rejected. A sample appended while remove() drops its adapter may be dropped too.   *
+*        output: true if the sample was stored                                           *
+*        input: wifi - interface name, metric - field, t_ms - time, value - sample       *
+*****************************************************************************************/
+	bool append(const std::string & wifi, iwMetric metric, int64_t t_ms, double value){
+	    std::shared_ptr<series> held = findOrAdd(wifi, metric);
+	    series & s = *held;
+	    int64_t t = t_ms / resolution * resolution;
+	    std::lock_guard<std::mutex> guard(s.lock);
+	    if (!s.blocks.empty() && t < s.blocks.back()->tLast) {
+		s.rejected++;
+		return false;
+	    }
+	    if (s.blocks.empty() || !s.blocks.back()->append(t, value)) {
+		std::unique_ptr<iwHistoryBlock> block = s.spare ? std::move(s.spare)
+		                                                : std::unique_ptr<iwHistoryBlock>(new iwHistoryBlock());
+		block->reset();
+		block->append(t, value);
+		s.blocks.push_back(std::move(block));
+	    }
+	    s.samples++;
+	    retain(s);
+	    return true;
+	}
+
+	// Appends every readable numeric field of a snapshot (ESSID and Access Point are skipped).
+	int record(const iwSnapshot & snap, int64_t t_ms){
+	    int stored = 0;
+	    for (int m = 0; m < metricCount; m++) {
+		if (m == metricEssid || m == metricAccessPoint) continue;
+		double value;
+		if (iwMetricValue(snap, (iwMetric)m, value) != iwOK) continue;
+		if (append(snap.name, (iwMetric)m, t_ms, value)) stored++;
+	    }
+	    return stored;
+	}
+
+/*****************************************************************************************
+* Query: decodes the samples of a series in [t0_ms, t1_ms), only touching the blocks     *
+* that overlap the window.                                                               *
+*        output: number of samples appended to out                                       *
+*****************************************************************************************/
+	size_t query(const std::string & wifi, iwMetric metric, int64_t t0_ms, int64_t t1_ms,
+		     std::vector<iwPoint> & out) const {
+	    std::shared_ptr<series> s = find(wifi, metric);
+	    if (!s) return 0;
+	    std::lock_guard<std::mutex> guard(s->lock);
+	    return decode(*s, t0_ms, t1_ms, [&out](int64_t t, double v) { out.push_back(iwPoint{t, v}); });
+	}
+
+/*****************************************************************************************
+* Downsample: min/max/mean of a series in buckets of bucket_ms over [t0_ms, t1_ms),      *
+* aggregated while decoding. Empty buckets are omitted.                                  *
+*        output: number of buckets appended to out                                       *
+*****************************************************************************************/
+	size_t downsample(const std::string & wifi, iwMetric metric, int64_t t0_ms, int64_t t1_ms, int64_t bucket_ms,
+			  std::vector<iwBucket> & out) const {
+	    std::shared_ptr<series> s = find(wifi, metric);
+	    if (!s || bucket_ms <= 0) return 0;
+	    size_t before = out.size();
+	    iwBucket current = {0, 0, 0, 0, 0};
+	    std::lock_guard<std::mutex> guard(s->lock);
+	    decode(*s, t0_ms, t1_ms, [&](int64_t t, double v) {
+		int64_t start = t0_ms + (t - t0_ms) / bucket_ms * bucket_ms;
+		if (current.count && start != current.start_ms) {
+		    current.mean /= current.count;
+		    out.push_back(current);
+		    current.count = 0;
+		}
+		if (current.count == 0) current = iwBucket{start, 0, v, v, 0};
+		current.count++;
+		current.min = std::min(current.min, v);
+		current.max = std::max(current.max, v);
+		current.mean += v;
+	    });
+	    if (current.count) {
+		current.mean /= current.count;
+		out.push_back(current);
+	    }
+	    return out.size() - before;
+	}
+
+	// Drops every series of an adapter.
+	void remove(const std::string & wifi){
+	    std::unique_lock<std::shared_mutex> guard(tableLock);
+	    for (int m = 0; m < metricCount; m++) table.erase(key(wifi, (iwMetric)m));
+	}
+
+/*****************************************************************************************
+* Usage: memory held by the history and how it compares with uncompressed samples.       *
+*****************************************************************************************/
+	iwHistoryUsage usage() const {
+	    iwHistoryUsage u = {0, 0, 0, 0, 0, 0};
+	    uint64_t bits = 0;
+	    std::shared_lock<std::shared_mutex> guard(tableLock);
+	    for (std::unordered_map<std::string, std::shared_ptr<series>>::const_iterator it = table.begin();
+		 it != table.end(); ++it) {
+		series & s = *it->second;
+		std::lock_guard<std::mutex> seriesGuard(s.lock);
+		u.series++;
+		u.blocks += s.blocks.size() + (s.spare ? 1 : 0);
+		u.samples += s.samples;
+		u.bytes += sizeof(series) + it->first.capacity()
+		    + (s.blocks.size() + (s.spare ? 1 : 0)) * (sizeof(iwHistoryBlock) + sizeof(void *));
+		for (size_t b = 0; b < s.blocks.size(); b++) bits += s.blocks[b]->usedBits();
+	    }
+	    u.rawBytes = u.samples * (sizeof(int64_t) + sizeof(double));
+	    u.bitsPerSample = u.samples ? (double)bits / u.samples : 0;
+	    return u;
+	}
+
+	// Writes the usage report in one line.
+	void printUsage(std::ostream & out) const {
+	    iwHistoryUsage u = usage();
+	    out << "history: " << u.series << " series, " << u.blocks << " blocks, " << u.samples << " samples, "
+		<< u.bytes / 1024 << " KiB (raw " << u.rawBytes / 1024 << " KiB), "
+		<< u.bitsPerSample << " bits/sample\n";
+	}
+};
+
+#endif
@@ -0,0 +1,61 @@
+/*****************************************************************************************
+* Title: 	iwLatency                                                                *
+* Purpose: 	Latency percentiles shared by the in-process loops (iwController,        *
+*		iwRoam): a fixed ring of the most recent samples summarized as count,    *
+*		mean, p50, p99 and maximum.                                              *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include<algorithm>
+#include<vector>
+#include<stdint.h>
+
+/*****************************************************************************************
+* Macros and Constants                                                                   *
+*****************************************************************************************/
+#ifndef _IWLATENCY
+#define _IWLATENCY
+
+// Latency percentiles, in microseconds.
+struct iwLatencySummary {
+    uint64_t count;
+    double mean_us;
+    double p50_us;
+    double p99_us;
+    double max_us;
+};
+
+/*****************************************************************************************
+* Latency Window: the most recent samples of a latency, kept in a fixed ring so that the *
+* percentiles follow the current behaviour of the loop or roam being measured.           *
+*****************************************************************************************/
+class iwLatencyWindow
+{
+   private:
+	static const size_t window = 4096;
+	std::vector<float> samples;
+	uint64_t count;
+	double sum;
+	double maximum;
+
+   public:
+	iwLatencyWindow() : samples(window), count(0), sum(0), maximum(0) {}
+	void add(double us){
+	    samples[count % window] = (float)us;
+	    count++;
+	    sum += us;
+	    maximum = std::max(maximum, us);
+	}
+	iwLatencySummary summary() const {
+	    iwLatencySummary s = {count, count ? sum / count : 0, 0, 0, maximum};
+	    size_t n = (size_t)std::min<uint64_t>(count, (uint64_t)window); // by value, window has no definition
+	    if (n == 0) return s;
+	    std::vector<float> sorted(samples.begin(), samples.begin() + n);
+	    std::sort(sorted.begin(), sorted.end());
+	    s.p50_us = sorted[(size_t)(0.5 * (n - 1) + 0.5)];
+	    s.p99_us = sorted[(size_t)(0.99 * (n - 1) + 0.5)];
+	    return s;
+	}
+};
+#endif
@@ -0,0 +1,513 @@
+/*****************************************************************************************
+* Title: 	iwRoam                                                                   *
+* Purpose: 	Fast roaming assistant for iwconfigAPI. Background scans (iwlist scan)   *
+*		keep a ranked cache of the access points in range, so the decision to    *
+*		roam never waits for a scan. A roam is started on request, or by check() *
+*		when the signal level of the current access point drops below the        *
+*		trigger level and a candidate of the same ESSID is better by the minimum *
+*		gain. A candidate last seen by a scan older than the validation age is   *
+*		confirmed by a new scan of the interface first and dropped if that scan  *
+*		no longer reports it. The candidate's channel is then set so the driver  *
+*		does not search for it, and the reassociation command is issued through  *
+*		the iwconfigAPI object and so through its backend, the fastest one       *
+*		available. Completion is detected from link events (iwEvents.h) when a   *
+*		source is given, and by polling the access point otherwise.              *
+*		Every roam is recorded with its latency broken down into selection,      *
+*		channel command, reassociation command, time to disconnect and downtime. *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include "iwconfigAPI.h"
+#include "iwEvents.h"
+#include "iwLatency.h"
+#include<algorithm>
+#include<atomic>
+#include<chrono>
+#include<condition_variable>
+#include<mutex>
+#include<thread>
+#include<unordered_map>
+#include<ctype.h>
+#include<stdint.h>
+
+/*****************************************************************************************
+* Macros and Constants                                                                   *
+*****************************************************************************************/
+#ifndef _IWROAM
+#define _IWROAM
+
+// Access point in the candidate cache of an interface.
+struct iwRoamCandidate {
+    std::string bssid;                // upper case, 00:11:22:AA:BB:CC
+    std::string essid;
+    int channel;
+    double frequency;            // Hz
+    double signal;               // dBm, smoothed over the scans that saw it
+    double score;                // signal plus the 5 GHz preference, candidates are sorted on it
+    std::chrono::steady_clock::time_point seen; // last scan that reported it
+    uint32_t seenCount;
+};
+
+// When and how to roam.
+struct iwRoamPolicy {
+    double trigger_dbm = -75;        // check() roams when the signal is below this level
+    double min_gain_db = 6;          // ... and a candidate scores this much more than the current AP
+    double band5_bonus_db = 3;       // score added to 5 GHz access points
+    double smoothing = 0.5;          // weight of a new scan in the smoothed signal
+    double candidate_ttl_ms = 15000; // candidates not seen for longer are dropped
+    double validate_ms = 2000;       // older candidates are confirmed by a scan before a roam, 0 never
+    double scan_interval_ms = 5000;  // background scans of run()
+    double check_interval_ms = 100;  // signal checks of run()
+    double holdoff_ms = 2000;        // minimum time between two roams triggered by check()
+    double timeout_ms = 3000;        // give up waiting for the association
+    double poll_ms = 5;              // access point polling period without an event source
+    bool presetChannel = true;       // set the candidate's channel before reassociating
+    bool sameEssid = true;           // only roam to the ESSID of the current access point
+};
+
+// This enumeration type reports how a roam ended.
+enum iwRoamOutcome {roamDone, roamTimeout, roamFailed, roamNoCandidate, roamBusy};
+
+// One roam. Latencies are in microseconds from the start of the roam unless noted.
+struct iwRoamRecord {
+    std::string wifi;
+    std::string from;                 // access point left, empty if unknown
+    std::string to;                   // access point asked for
+    int channel;                 // channel preset, 0 if none
+    bool triggered;              // started by check() rather than requested
+    iwRoamOutcome outcome;
+    double signal_dbm;           // signal level of the old link when the roam started
+    std::chrono::steady_clock::time_point start;
+    bool validated;              // the candidate was confirmed by a scan during selection
+    double select_us;            // candidate choice from the cache, with the validation scan
+    double channel_us;           // duration of the channel command
+    double command_us;           // duration of the reassociation command
+    double disconnect_us;        // until the old link was reported down, 0 if not reported
+    double downtime_us;          // link down (or command issued) until associated
+    double total_us;             // until associated, or until the roam was given up
+};
+
+/*****************************************************************************************
+* Roam Record Reason: readable name of an outcome.                                       *
+*****************************************************************************************/
+inline const char * iwRoamReason(iwRoamOutcome outcome){
+    switch (outcome) {
+	case roamDone: return "done";
+	case roamTimeout: return "timeout";
+	case roamFailed: return "failed";
+	case roamNoCandidate: return "no-candidate";
+	default: return "busy";
+    }
+}
+
+// Interface names without the padding getWIFIList leaves, BSSIDs in upper case.
+inline std::string iwRoamName(const std::string & wifi){
+    size_t end = wifi.find_last_not_of(' ');
+    return end == std::string::npos ? std::string() : wifi.substr(0, end + 1);
+}
+inline std::string iwRoamBssid(std::string bssid){
+    for (size_t i = 0; i < bssid.length(); i++) bssid[i] = toupper((unsigned char)bssid[i]);
+    return bssid;
+}
+
+/*****************************************************************************************
+* Roam Assistant                                                                         *
+*****************************************************************************************/
+class iwRoamAssistant
+{
+   public:
+	struct statistics {
+	    uint64_t roams;           // roams that reached the reassociation command
+	    uint64_t done, timeouts, failures, noCandidate, busy;
+	    uint64_t scans, scanFailures;
+	    iwLatencySummary command;     // reassociation command
+	    iwLatencySummary downtime;    // completed roams only
+	    iwLatencySummary total;       // completed roams only
+	};
+
+   private:
+	struct iface {
+	    std::vector<iwRoamCandidate> candidates;  // best score first
+	    std::string current;                      // access point, empty if not associated or unknown
+	    std::string essid;
+	    int channel = 0;
+	    double signal = -174;
+	    bool roaming = false;
+	    std::chrono::steady_clock::time_point lastScan, lastRoam;
+	    // link events of the roam in progress
+	    std::string awaited;
+	    bool disconnected = false, associated = false, failed = false;
+	    std::string associatedTo;
+	    std::chrono::steady_clock::time_point disconnectTime, associateTime;
+	};
+
+	iwconfigAPI & wifiAPI;
+	iwLinkEventSource * events;
+	uint64_t subscription;
+	iwRoamPolicy policy;
+	std::mutex lock;                              // never held across a command
+	std::condition_variable linkChanged;
+	std::unordered_map<std::string, iface> ifaces;
+	std::vector<iwRoamRecord> records;            // ring of the last recordLimit roams
+	size_t recordCount;
+	static const size_t recordLimit = 1024;
+	uint64_t scans, scanFailures, outcomes[roamBusy + 1];
+	iwLatencyWindow commandTime, downtime, totalTime;
+
+	static double microseconds(std::chrono::steady_clock::duration d){
+	    return std::chrono::duration<double, std::micro>(d).count();
+	}
+	static std::chrono::steady_clock::duration milliseconds(double ms){
+	    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(ms));
+	}
+	double score(double signal, double frequency) const {
+	    return signal + (frequency > 4e9 ? policy.band5_bonus_db : 0);
+	}
+	// Score a candidate needs to be worth leaving the current access point for.
+	double minScore(const iface & f, bool triggered) const {
+	    return triggered ? score(f.signal, f.channel > 14 ? 5e9 : 2.4e9) + policy.min_gain_db : -1e9;
+	}
+
+/*****************************************************************************************
+* On Link Event: called on the source's thread. The current access point is kept up to   *
+* date for every interface and the roam in progress on the interface is woken up.        *
+*****************************************************************************************/
+	void onLinkEvent(const iwLinkEvent & event){
+	    std::lock_guard<std::mutex> guard(lock);
+	    std::unordered_map<std::string, iface>::iterator it = ifaces.find(event.wifi);
+	    if (it == ifaces.end()) return;
+	    iface & f = it->second;
+	    std::string bssid = iwRoamBssid(event.bssid);
+	    if (event.type == iwLinkAssociated) {
+		f.current = bssid;
+		if (f.roaming && !f.associated) {
+			f.associated = true;
+			f.associatedTo = bssid;
+			f.associateTime = event.time;
+		}
+	    }
+	    else if (event.type == iwLinkDisconnected) {
+		f.current.clear();
+		if (f.roaming && !f.disconnected) {
+			f.disconnected = true;
+			f.disconnectTime = event.time;
+		}
+	    }
+	    else if (f.roaming && (bssid.empty() || bssid == f.awaited)) f.failed = true;
+	    linkChanged.notify_all();
+	}
+
+/*****************************************************************************************
+* Merge Scan: fold one scan into the candidate cache of an interface, drop candidates    *
+* that have not been seen for the candidate lifetime and sort the rest by score.         *
+* Called with the lock held.                                                             *
+*****************************************************************************************/
+	void mergeScan(iface & f, const std::vector<iwScanCell> & cells, std::chrono::steady_clock::time_point now){
+	    for (size_t i = 0; i < cells.size(); i++) {
+		std::string bssid = iwRoamBssid(cells[i].bssid);
+		size_t c = 0;
+		while (c < f.candidates.size() && f.candidates[c].bssid != bssid) c++;
+		if (c == f.candidates.size()) {
+			iwRoamCandidate added;
+			added.bssid = bssid;
+			added.signal = cells[i].signal;
+			added.seenCount = 0;
+			f.candidates.push_back(added);
+		}
+		iwRoamCandidate & candidate = f.candidates[c];
+		candidate.essid = cells[i].essid;
+		candidate.channel = cells[i].channel;
+		candidate.frequency = cells[i].frequency;
+		if (candidate.seenCount) candidate.signal += policy.smoothing * (cells[i].signal - candidate.signal);
+		candidate.score = score(candidate.signal, candidate.frequency);
+		candidate.seen = now;
+		candidate.seenCount++;
+	    }
+	    std::chrono::steady_clock::time_point oldest = now - milliseconds(policy.candidate_ttl_ms);
+	    size_t kept = 0;
+	    for (size_t c = 0; c < f.candidates.size(); c++) {
+		if (f.candidates[c].seen >= oldest) f.candidates[kept++] = f.candidates[c];
+	    }
+	    f.candidates.resize(kept);
+	    std::sort(f.candidates.begin(), f.candidates.end(),
+		 [](const iwRoamCandidate & a, const iwRoamCandidate & b) { return a.score > b.score; });
+	}
+
+/*****************************************************************************************
+* Select: best candidate seen since oldest other than the current access point, or the   *
+* requested one. Called with the lock held.                                              *
+*        output: index in the candidates, -1 if none qualifies                           *
+*****************************************************************************************/
+	int select(const iface & f, const std::string & bssid, double minScore, std::chrono::steady_clock::time_point oldest) const {
+	    for (size_t c = 0; c < f.candidates.size(); c++) {
+		const iwRoamCandidate & candidate = f.candidates[c];
+		if (candidate.seen < oldest) continue;
+		if (!bssid.empty()) {
+			if (candidate.bssid == bssid) return (int)c;
+			continue;
+		}
+		if (candidate.bssid == f.current || candidate.score < minScore) continue;
+		if (policy.sameEssid && !f.essid.empty() && candidate.essid != f.essid) continue;
+		return (int)c;
+	    }
+	    return -1;
+	}
+
+	void record(const iwRoamRecord & r){
+	    if (records.size() < recordLimit) records.push_back(r);
+	    else records[recordCount % recordLimit] = r;
+	    recordCount++;
+	    outcomes[r.outcome]++;
+	    if (r.outcome == roamNoCandidate || r.outcome == roamBusy) return;
+	    commandTime.add(r.command_us);
+	    if (r.outcome != roamDone) return;
+	    downtime.add(r.downtime_us);
+	    totalTime.add(r.total_us);
+	}
+
+/*****************************************************************************************
+* Reassociate: select the target, confirm it with a scan when it was last seen before    *
+* the validation age, preset its channel, issue the reassociation command and wait for   *
+* the association. A candidate the validation scan does not report is not used: a roam   *
+* to the best candidate ends with roamNoCandidate, a requested access point is tried     *
+* without a channel as when it is not in the cache.                                      *
+*****************************************************************************************/
+	iwRoamRecord reassociate(const std::string & name, const std::string & bssid, bool triggered){
+	    iwRoamRecord r;
+	    r.wifi = name;
+	    r.to = bssid;
+	    r.channel = 0;
+	    r.triggered = triggered;
+	    r.validated = false;
+	    r.outcome = roamNoCandidate;
+	    r.signal_dbm = -174;
+	    r.start = std::chrono::steady_clock::now();
+	    r.select_us = r.channel_us = r.command_us = r.disconnect_us = r.downtime_us = r.total_us = 0;
+	    std::chrono::steady_clock::time_point oldest = r.start - milliseconds(policy.candidate_ttl_ms);
+	    if (policy.validate_ms > 0) {
+		std::chrono::steady_clock::time_point validAfter = r.start - milliseconds(policy.validate_ms);
+		bool stale;
+		{
+		std::lock_guard<std::mutex> guard(lock);
+		iface & f = ifaces[name];
+		int c = f.roaming ? -1 : select(f, bssid, minScore(f, triggered), oldest);
+		stale = c >= 0 && f.candidates[c].seen < validAfter;
+		}
+		if (stale) { // only what this scan reports qualifies
+			validAfter = std::chrono::steady_clock::now();
+			scan(name);
+			r.validated = true;
+		}
+		oldest = std::max(oldest, validAfter);
+	    }
+	    int currentChannel;
+	    {
+	    std::unique_lock<std::mutex> guard(lock);
+	    iface & f = ifaces[name];
+	    r.from = f.current;
+	    r.signal_dbm = f.signal;
+	    if (f.roaming) r.outcome = roamBusy;
+	    else {
+		int c = select(f, bssid, minScore(f, triggered), oldest);
+		if (c >= 0) {
+			r.to = f.candidates[c].bssid;
+			r.channel = policy.presetChannel ? f.candidates[c].channel : 0;
+		}
+		if (c >= 0 || !bssid.empty()) { // a requested AP outside the cache is tried without a channel
+			r.outcome = roamDone;
+			f.roaming = true;
+			f.awaited = r.to;
+			f.disconnected = f.associated = f.failed = false;
+		}
+	    }
+	    currentChannel = f.channel;
+	    r.select_us = microseconds(std::chrono::steady_clock::now() - r.start);
+	    if (r.outcome != roamDone) {
+		record(r);
+		return r;
+	    }
+	    }
+
+	    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	    if (r.channel > 0 && r.channel != currentChannel) {
+		wifiAPI.setChannel(name, r.channel);
+		r.channel_us = microseconds(std::chrono::steady_clock::now() - t0);
+	    }
+	    else r.channel = 0;
+	    std::chrono::steady_clock::time_point issued = std::chrono::steady_clock::now();
+	    wifiAPI.setAccessPoint(name, r.to);
+	    r.command_us = microseconds(std::chrono::steady_clock::now() - issued);
+	    std::chrono::steady_clock::time_point deadline = r.start + milliseconds(policy.timeout_ms);
+
+	    std::unique_lock<std::mutex> guard(lock);
+	    iface & f = ifaces[name];
+	    if (events) {
+		linkChanged.wait_until(guard, deadline, [&f] { return f.associated || f.failed; });
+	    }
+	    else { // no event source: poll the access point
+		while (!f.associated && std::chrono::steady_clock::now() < deadline) {
+			guard.unlock();
+			std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(policy.poll_ms));
+			iwResult<std::string> ap = wifiAPI.tryGetAccessPoint(name);
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			guard.lock();
+			if (ap.ok() && iwRoamBssid(ap.value) == r.to) {
+				f.associated = true;
+				f.associatedTo = r.to;
+				f.associateTime = now;
+				f.current = r.to;
+			}
+		}
+	    }
+	    if (f.disconnected) r.disconnect_us = microseconds(f.disconnectTime - r.start);
+	    if (f.associated && f.associatedTo == r.to) {
+		r.outcome = roamDone;
+		r.downtime_us = microseconds(f.associateTime - (f.disconnected ? f.disconnectTime : issued));
+		r.total_us = microseconds(f.associateTime - r.start);
+	    }
+	    else {
+		r.outcome = f.associated || f.failed ? roamFailed : roamTimeout;
+		r.total_us = microseconds(std::chrono::steady_clock::now() - r.start);
+	    }
+	    f.roaming = false;
+	    f.lastRoam = std::chrono::steady_clock::now();
+	    if (r.outcome == roamDone && r.channel > 0) f.channel = r.channel;
+	    record(r);
+	    return r;
+	}
+
+   public:
+	// events may be NULL: completion is then detected by polling the access point.
+	iwRoamAssistant(iwconfigAPI & api, iwLinkEventSource * linkEvents, const iwRoamPolicy & roamPolicy = iwRoamPolicy())
+		: wifiAPI(api), events(linkEvents), subscription(0), policy(roamPolicy), recordCount(0),
+		  scans(0), scanFailures(0) {
+	    for (int i = 0; i <= roamBusy; i++) outcomes[i] = 0;
+	    if (events) subscription = events->subscribe([this](const iwLinkEvent & event) { onLinkEvent(event); });
+	}
+	~iwRoamAssistant(){
+	    if (events) events->unsubscribe(subscription);
+	}
+	iwRoamAssistant(const iwRoamAssistant &) = delete;
+	iwRoamAssistant & operator=(const iwRoamAssistant &) = delete;
+
+	// Interfaces roamed by run(). scan, roam and check add the interface they are given.
+	void addInterface(const std::string & wifi){
+	    std::lock_guard<std::mutex> guard(lock);
+	    ifaces[iwRoamName(wifi)];
+	}
+
+/*****************************************************************************************
+* Scan: one scan of an interface folded into its candidate cache. Slow (the driver scans *
+* every channel); run() calls it on a background thread.                                 *
+*        output: status of iwconfigAPI::tryScan                                          *
+*****************************************************************************************/
+	iwStatus scan(const std::string & wifi){
+	    std::string name = iwRoamName(wifi);
+	    std::vector<iwScanCell> cells;
+	    iwStatus status = wifiAPI.tryScan(name, cells);
+	    std::lock_guard<std::mutex> guard(lock);
+	    iface & f = ifaces[name];
+	    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	    f.lastScan = now;
+	    scans++;
+	    if (status != iwOK) scanFailures++;
+	    else mergeScan(f, cells, now);
+	    return status;
+	}
+
+	// Copy of the candidate cache of an interface, best score first.
+	std::vector<iwRoamCandidate> candidates(const std::string & wifi){
+	    std::lock_guard<std::mutex> guard(lock);
+	    std::unordered_map<std::string, iface>::const_iterator it = ifaces.find(iwRoamName(wifi));
+	    return it == ifaces.end() ? std::vector<iwRoamCandidate>() : it->second.candidates;
+	}
+
+/*****************************************************************************************
+* Roam: reassociate now, with the best cached candidate other than the current access    *
+* point or with bssid when one is given. Blocks until associated or the timeout.         *
+*        output: record of the roam, also kept in history()                              *
+*        input: wifi - string containing wifi adapter/interface name.                    *
+*               bssid - access point to join, empty for the best candidate               *
+*****************************************************************************************/
+	iwRoamRecord roam(const std::string & wifi, const std::string & bssid = ""){
+	    return reassociate(iwRoamName(wifi), iwRoamBssid(bssid), false);
+	}
+
+/*****************************************************************************************
+* Check: read the link with one snapshot command and roam when the signal is below the   *
+* trigger level, a candidate is better by the minimum gain and the last roam is older    *
+* than the hold-off time.                                                                *
+*        output: true if a roam was attempted, roamed then holds its record              *
+*****************************************************************************************/
+	bool check(const std::string & wifi, iwRoamRecord & roamed){
+	    std::string name = iwRoamName(wifi);
+	    iwSnapshot snap;
+	    if (wifiAPI.tryGetSnapshot(name, snap) != iwOK) return false;
+	    {
+	    std::lock_guard<std::mutex> guard(lock);
+	    iface & f = ifaces[name];
+	    if (f.roaming) return false;
+	    f.current = snap.accessPoint.ok() ? iwRoamBssid(snap.accessPoint.value) : std::string();
+	    if (snap.essid.ok()) f.essid = snap.essid.value;
+	    if (snap.channel.ok()) f.channel = snap.channel.value;
+	    f.signal = snap.signal.ok() ? snap.signal.value : -174;
+	    if (f.current.empty() || f.signal >= policy.trigger_dbm) return false;
+	    if (std::chrono::steady_clock::now() - f.lastRoam < milliseconds(policy.holdoff_ms)) return false;
+	    std::chrono::steady_clock::time_point oldest = std::chrono::steady_clock::now() - milliseconds(policy.candidate_ttl_ms);
+	    if (select(f, "", minScore(f, true), oldest) < 0) return false;
+	    }
+	    roamed = reassociate(name, "", true);
+	    return roamed.outcome != roamNoCandidate && roamed.outcome != roamBusy;
+	}
+
+/*****************************************************************************************
+* Run: scan every interface on a background thread every scan interval and check every   *
+* interface every check interval, until stop is set.                                     *
+*****************************************************************************************/
+	void run(const std::atomic<bool> & stop){
+	    std::thread scanner([this, &stop] {
+		while (!stop.load(std::memory_order_relaxed)) {
+			std::vector<std::string> names = interfaces();
+			for (size_t i = 0; i < names.size() && !stop.load(std::memory_order_relaxed); i++) scan(names[i]);
+			std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now() + milliseconds(policy.scan_interval_ms);
+			while (!stop.load(std::memory_order_relaxed) && std::chrono::steady_clock::now() < next)
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	    });
+	    iwRoamRecord roamed;
+	    while (!stop.load(std::memory_order_relaxed)) {
+		std::vector<std::string> names = interfaces();
+		for (size_t i = 0; i < names.size(); i++) check(names[i], roamed);
+		std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(policy.check_interval_ms));
+	    }
+	    scanner.join();
+	}
+
+	std::vector<std::string> interfaces(){
+	    std::lock_guard<std::mutex> guard(lock);
+	    std::vector<std::string> names;
+	    for (std::unordered_map<std::string, iface>::const_iterator it = ifaces.begin(); it != ifaces.end(); ++it)
+		names.push_back(it->first);
+	    return names;
+	}
+
+	// The last roams, oldest first.
+	std::vector<iwRoamRecord> history(){
+	    std::lock_guard<std::mutex> guard(lock);
+	    if (recordCount <= recordLimit) return records;
+	    std::vector<iwRoamRecord> ordered;
+	    for (size_t i = 0; i < recordLimit; i++) ordered.push_back(records[(recordCount + i) % recordLimit]);
+	    return ordered;
+	}
+
+	statistics getStatistics(){
+	    std::lock_guard<std::mutex> guard(lock);
+	    statistics s = {outcomes[roamDone] + outcomes[roamTimeout] + outcomes[roamFailed],
+			    outcomes[roamDone], outcomes[roamTimeout], outcomes[roamFailed], outcomes[roamNoCandidate],
+			    outcomes[roamBusy], scans, scanFailures,
+			    commandTime.summary(), downtime.summary(), totalTime.summary()};
+	    return s;
+	}
+};
+#endif
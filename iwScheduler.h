@@ -0,0 +1,424 @@
+/*****************************************************************************************
+* Title: 	iwScheduler                                                              *
+* Purpose: 	Adaptive polling scheduler for iwconfigAPI. Every (adapter, metric) pair *
+* 		has its own sampling interval kept in a hierarchical timer wheel. Reads  *
+*		that fall due in the same tick for the same adapter are coalesced into a *
+*		single snapshot fetch (one iwconfig command), and each interval adapts   *
+*		to how much the metric is actually changing:                             *
+*		    - the deviation of a metric is tracked as an exponentially weighted  *
+*		      mean of its squared change between samples;                        *
+*		    - above its tolerance the interval is halved (down to minimum), well *
+*		      below it the interval grows by 25% (up to maximum);                *
+*		    - notify() pulls a metric in immediately, optionally for a burst of  *
+*		      samples at the minimum interval (roaming, link events ...).        *
+*		A token bucket caps the number of fetches per second over all adapters;  *
+*		fetches over budget are deferred to the next tick rather than dropped.   *
+*		Monitoring cost therefore follows how much is changing, not how many     *
+*		adapters there are.                                                      *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include "iwconfigAPI.h"
+#include<chrono>
+#include<cmath>
+#include<thread>
+#include<unordered_map>
+#include<stdint.h>
+#include<functional>
+#include<mutex>
+#include<string.h>
+
+/*****************************************************************************************
+* Macros and Constants                                                                   *
+*****************************************************************************************/
+#ifndef _IWSCHEDULER
+#define _IWSCHEDULER
+
+// Sampling policy of one metric. Intervals are in milliseconds; tolerance is the change
+// (in the metric's unit) considered significant. String metrics count any change as
+// twice the tolerance.
+struct iwPollPolicy {
+    double start_ms;
+    double min_ms;
+    double max_ms;
+    double tolerance;
+};
+
+/*****************************************************************************************
+* Scheduler                                                                              *
+*****************************************************************************************/
+class iwScheduler
+{
+   public:
+	// Called once per delivered sample, outside the scheduler lock. The snapshot holds
+	// every field of the adapter as read by the coalesced fetch.
+	typedef std::function<void(const std::string & wifi, iwMetric metric, const iwSnapshot & snap)> sampleCallback;
+
+	struct statistics {
+	    uint64_t ticks;       // wheel ticks processed
+	    uint64_t fetches;     // snapshot commands issued
+	    uint64_t samples;     // (adapter, metric) samples delivered
+	    uint64_t deferred;    // fetches pushed to a later tick by the budget
+	    uint64_t failures;    // fetches that did not return iwOK
+	};
+
+   private:
+	static const int wheelBits = 6;
+	static const int wheelSlots = 1 << wheelBits;
+	static const int wheelLevels = 4;          // 64^4 ticks, over 4 days at 10 ms
+	static const uint32_t none = 0xffffffff;
+
+	struct entry {
+	    uint32_t adapter;
+	    iwMetric metric;
+	    iwPollPolicy policy;
+	    double interval_ms;
+	    double last;
+	    double deviation;      // EWMA of squared change
+	    bool haveLast;
+	    bool live;
+	    int burst;             // samples left at the minimum interval
+	    uint64_t due;          // tick
+	    uint32_t next, prev;   // wheel slot list
+	    int level, slot;       // -1 when not in the wheel
+	};
+	struct adapter {
+	    std::string name;
+	    bool live;
+	    bool fetch;            // has a due metric in the current tick
+	    iwSnapshot snap;
+	    iwStatus status;
+	};
+
+	iwconfigAPI & wifiAPI;
+	std::chrono::milliseconds tick;
+	sampleCallback callback;
+	iwPollPolicy defaults[metricCount];
+	std::mutex lock;
+
+	std::vector<entry> entries;
+	std::vector<uint32_t> freeEntries;
+	std::vector<std::unique_ptr<adapter>> adapters; // indexed under the lock only, add() may reallocate it
+	std::unordered_map<std::string, uint32_t> byName;
+	uint32_t heads[wheelLevels][wheelSlots];
+	uint64_t current;
+	std::chrono::steady_clock::time_point origin;
+
+	double budgetRate;     // fetches per second, 0 = unlimited
+	double budgetBurst;
+	double tokens;
+
+	std::vector<uint32_t> due;          // reused every tick
+	std::vector<adapter *> dueAdapters; // reused every tick; adapters are never freed, so the
+	                               // pointers stay valid while the lock is dropped
+	statistics stats;
+
+	void unlink(uint32_t id){
+	    entry & e = entries[id];
+	    if (e.level < 0) return;
+	    if (e.prev != none) entries[e.prev].next = e.next;
+	    else heads[e.level][e.slot] = e.next;
+	    if (e.next != none) entries[e.next].prev = e.prev;
+	    e.level = -1;
+	}
+	void link(uint32_t id, int level, int slot){
+	    entry & e = entries[id];
+	    e.level = level;
+	    e.slot = slot;
+	    e.prev = none;
+	    e.next = heads[level][slot];
+	    if (e.next != none) entries[e.next].prev = id;
+	    heads[level][slot] = id;
+	}
+	// Place an entry in the wheel level that covers its distance from now.
+	void insert(uint32_t id){
+	    entry & e = entries[id];
+	    const uint64_t span = (uint64_t)1 << (wheelBits * wheelLevels);
+	    if (e.due < current) e.due = current;
+	    if (e.due - current >= span) e.due = current + span - 1; // clamp to the wheel's reach
+	    uint64_t delta = e.due - current;
+	    int level = 0;
+	    while (level < wheelLevels - 1 && delta >= ((uint64_t)1 << (wheelBits * (level + 1)))) level++;
+	    link(id, level, (int)((e.due >> (wheelBits * level)) & (wheelSlots - 1)));
+	}
+	void schedule(uint32_t id, double after_ms){
+	    entry & e = entries[id];
+	    unlink(id);
+	    uint64_t ticks = (uint64_t)std::ceil(after_ms / tick.count());
+	    e.due = current + (ticks ? ticks : 1);
+	    insert(id);
+	}
+	// Re-insert every entry of a higher level slot that has come into range.
+	void cascade(int level){
+	    int slot = (int)((current >> (wheelBits * level)) & (wheelSlots - 1));
+	    uint32_t id = heads[level][slot];
+	    heads[level][slot] = none;
+	    while (id != none) {
+		uint32_t next = entries[id].next;
+		entries[id].level = -1;
+		insert(id);
+		id = next;
+	    }
+	}
+	// Variance driven interval update after a sample.
+	void adapt(entry & e, iwStatus status, double value){
+	    if (status == iwOK || status == iwOff) {
+		double change = 0;
+		if (e.haveLast) {
+			change = value - e.last;
+			if (e.metric == metricEssid || e.metric == metricAccessPoint) change = change != 0 ? 2 * e.policy.tolerance : 0;
+		}
+		e.deviation = 0.7 * e.deviation + 0.3 * change * change;
+		e.last = value;
+		e.haveLast = true;
+	    }
+	    double normalized = std::sqrt(e.deviation) / (e.policy.tolerance > 0 ? e.policy.tolerance : 1);
+	    if (e.burst > 0) {
+		e.burst--;
+		e.interval_ms = e.policy.min_ms;
+	    }
+	    else if (normalized > 1) e.interval_ms = std::max(e.policy.min_ms, e.interval_ms / 2);
+	    else if (normalized < 0.5) e.interval_ms = std::min(e.policy.max_ms, e.interval_ms * 1.25);
+	}
+	void refill(){
+	    if (budgetRate <= 0) return;
+	    tokens = std::min(budgetBurst, tokens + budgetRate * tick.count() / 1000.0);
+	}
+
+/*****************************************************************************************
+* Process Tick: advance the wheel by one tick and sample everything due in it. The lock  *
+* is dropped while the snapshot commands run; meanwhile only the adapters collected in   *
+* dueAdapters are touched, never the adapters or entries vectors.                        *
+*****************************************************************************************/
+	void processTick(std::unique_lock<std::mutex> & guard){
+	    current++;
+	    stats.ticks++;
+	    refill();
+	    for (int level = 1; level < wheelLevels; level++) {
+		if ((current & (((uint64_t)1 << (wheelBits * level)) - 1)) != 0) break;
+		cascade(level);
+	    }
+	    int slot = (int)(current & (wheelSlots - 1));
+	    due.clear();
+	    dueAdapters.clear();
+	    for (uint32_t id = heads[0][slot]; id != none; ) {
+		uint32_t next = entries[id].next;
+		entry & e = entries[id];
+		if (e.due <= current) {
+			unlink(id);
+			due.push_back(id);
+			adapter * a = adapters[e.adapter].get();
+			if (!a->fetch) {
+				a->fetch = true;
+				dueAdapters.push_back(a);
+			}
+		}
+		id = next;
+	    }
+	    if (due.empty()) return;
+	    // Budget: adapters over budget are deferred with all their due metrics.
+	    for (size_t i = 0; i < dueAdapters.size(); i++) {
+		adapter & a = *dueAdapters[i];
+		if (budgetRate > 0 && tokens < 1) {
+			a.fetch = false;
+			stats.deferred++;
+			continue;
+		}
+		if (budgetRate > 0) tokens -= 1;
+	    }
+	    for (size_t i = 0; i < due.size(); i++) {
+		entry & e = entries[due[i]];
+		if (!adapters[e.adapter]->fetch) schedule(due[i], tick.count());
+	    }
+	    // Fetch one snapshot per adapter without holding the lock.
+	    guard.unlock();
+	    for (size_t i = 0; i < dueAdapters.size(); i++) {
+		adapter & a = *dueAdapters[i];
+		if (!a.fetch) continue;
+		a.status = wifiAPI.tryGetSnapshot(a.name, a.snap);
+	    }
+	    guard.lock();
+	    for (size_t i = 0; i < dueAdapters.size(); i++) {
+		adapter & a = *dueAdapters[i];
+		if (!a.fetch) continue;
+		stats.fetches++;
+		if (a.status != iwOK) stats.failures++;
+	    }
+	    for (size_t i = 0; i < due.size(); i++) {
+		entry & e = entries[due[i]];
+		if (!e.live || !adapters[e.adapter]->fetch || e.level >= 0) continue; // removed, deferred or rescheduled meanwhile
+		adapter & a = *adapters[e.adapter];
+		double value = 0;
+		iwStatus status = a.status == iwOK ? iwMetricValue(a.snap, e.metric, value) : a.status;
+		adapt(e, status, value);
+		schedule(due[i], e.interval_ms);
+		stats.samples++;
+		if (callback && a.status == iwOK) {
+			iwMetric metric = e.metric;
+			guard.unlock();
+			callback(a.name, metric, a.snap);
+			guard.lock();
+		}
+	    }
+	    for (size_t i = 0; i < dueAdapters.size(); i++) dueAdapters[i]->fetch = false;
+	}
+
+   public:
+	iwScheduler(iwconfigAPI & api, sampleCallback onSample,
+		    std::chrono::milliseconds resolution = std::chrono::milliseconds(10))
+		: wifiAPI(api), tick(resolution.count() > 0 ? resolution : std::chrono::milliseconds(1)), callback(onSample),
+		  current(0), origin(std::chrono::steady_clock::now()), budgetRate(0), budgetBurst(0), tokens(0) {
+	    for (int level = 0; level < wheelLevels; level++) {
+		for (int slot = 0; slot < wheelSlots; slot++) heads[level][slot] = none;
+	    }
+	    //                             start     min      max  tolerance
+	    defaults[metricSignal]      = {1000,    100,    5000,  2};    // dBm, noisy
+	    defaults[metricBitrate]     = {1000,    500,   10000,  1};    // Mb/s
+	    defaults[metricTxpower]     = {5000,   1000,   60000,  0.5};  // dBm
+	    defaults[metricFrequency]   = {5000,   1000,   60000,  1};    // Hz
+	    defaults[metricChannel]     = {5000,   1000,   60000,  0.5};
+	    defaults[metricAccessPoint] = {5000,   1000,   60000,  1};
+	    defaults[metricEssid]       = {10000,  1000,  300000,  1};
+	    defaults[metricMode]        = {10000,  1000,  300000,  0.5};  // almost never changes
+	    defaults[metricRetry]       = {10000,  1000,  300000,  0.5};
+	    defaults[metricRts]         = {10000,  1000,  300000,  0.5};
+	    defaults[metricFrag]        = {10000,  1000,  300000,  0.5};
+	    memset(&stats, 0, sizeof stats);
+	}
+	iwScheduler(const iwScheduler &) = delete;
+	iwScheduler & operator=(const iwScheduler &) = delete;
+
+	// Policy used for metrics of adapters added afterwards.
+	void setDefaultPolicy(iwMetric metric, const iwPollPolicy & policy){
+	    std::lock_guard<std::mutex> guard(lock);
+	    defaults[metric] = policy;
+	}
+	// Cap the snapshot fetches over all adapters; 0 removes the cap.
+	void setBudget(double fetchesPerSecond, double burst = 0){
+	    std::lock_guard<std::mutex> guard(lock);
+	    budgetRate = fetchesPerSecond;
+	    budgetBurst = burst > 1 ? burst : std::max(1.0, fetchesPerSecond * tick.count() / 1000.0);
+	    tokens = budgetBurst;
+	}
+
+/*****************************************************************************************
+* Add/Remove Adapter: start or stop sampling the given metrics of an adapter. Metrics    *
+* start at their policy's start interval, spread over the first interval so that adding  *
+* many adapters at once does not produce one large burst.                                *
+*****************************************************************************************/
+	void add(const std::string & wifi, const std::vector<iwMetric> & metrics = std::vector<iwMetric>()){
+	    std::lock_guard<std::mutex> guard(lock);
+	    if (byName.count(wifi)) return;
+	    uint32_t index = adapters.size();
+	    adapters.emplace_back(new adapter());
+	    adapter & a = *adapters[index];
+	    a.name = wifi;
+	    a.live = true;
+	    a.fetch = false;
+	    byName[wifi] = index;
+	    size_t count = metrics.empty() ? (size_t)metricCount : metrics.size();
+	    for (size_t m = 0; m < count; m++) {
+		uint32_t id;
+		if (!freeEntries.empty()) {
+			id = freeEntries.back();
+			freeEntries.pop_back();
+		}
+		else {
+			id = entries.size();
+			entries.emplace_back();
+		}
+		entry & e = entries[id];
+		e.adapter = index;
+		e.metric = metrics.empty() ? (iwMetric)m : metrics[m];
+		e.policy = defaults[e.metric];
+		e.interval_ms = e.policy.start_ms;
+		e.deviation = 0;
+		e.haveLast = false;
+		e.live = true;
+		e.burst = 0;
+		e.level = -1;
+		// phase spread: hash of the name picks the offset inside the first interval
+		double phase = (std::hash<std::string>()(wifi) % 1000) / 1000.0;
+		schedule(id, phase * e.interval_ms);
+	    }
+	}
+	void remove(const std::string & wifi){
+	    std::lock_guard<std::mutex> guard(lock);
+	    std::unordered_map<std::string, uint32_t>::iterator found = byName.find(wifi);
+	    if (found == byName.end()) return;
+	    uint32_t index = found->second;
+	    byName.erase(found);
+	    for (uint32_t id = 0; id < entries.size(); id++) {
+		if (entries[id].live && entries[id].adapter == index) {
+			unlink(id);
+			entries[id].live = false;
+			freeEntries.push_back(id);
+		}
+	    }
+	    adapters[index]->live = false;
+	}
+
+/*****************************************************************************************
+* Notify: an event says a metric may have changed. It is sampled on the next tick and    *
+* the following burst samples are taken at its minimum interval.                         *
+*****************************************************************************************/
+	void notify(const std::string & wifi, iwMetric metric, int burst = 0){
+	    std::lock_guard<std::mutex> guard(lock);
+	    std::unordered_map<std::string, uint32_t>::iterator found = byName.find(wifi);
+	    if (found == byName.end()) return;
+	    for (uint32_t id = 0; id < entries.size(); id++) {
+		entry & e = entries[id];
+		if (e.live && e.adapter == found->second && e.metric == metric) {
+			e.burst = burst;
+			e.interval_ms = e.policy.min_ms;
+			schedule(id, 0);
+		}
+	    }
+	}
+
+/*****************************************************************************************
+* Advance: process every tick that has elapsed up to now. Call it from a poll loop, or   *
+* use run() which sleeps until the next tick itself. Only one thread may drive the       *
+* scheduler; add, remove and notify may be called from any thread.                       *
+*        output: number of ticks processed                                               *
+*****************************************************************************************/
+	uint64_t advance(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()){
+	    std::unique_lock<std::mutex> guard(lock);
+	    uint64_t target = (uint64_t)((now - origin) / tick);
+	    uint64_t processed = 0;
+	    while (current < target) {
+		processTick(guard);
+		processed++;
+	    }
+	    return processed;
+	}
+	void run(const std::atomic<bool> & stop){
+	    while (!stop.load()) {
+		std::chrono::steady_clock::time_point next;
+		{
+		std::lock_guard<std::mutex> guard(lock);
+		next = origin + tick * (current + 1);
+		}
+		std::this_thread::sleep_until(next);
+		advance();
+	    }
+	}
+
+	statistics getStatistics(){
+	    std::lock_guard<std::mutex> guard(lock);
+	    return stats;
+	}
+	// Current sampling interval of a metric in milliseconds, 0 if it is not scheduled.
+	double interval(const std::string & wifi, iwMetric metric){
+	    std::lock_guard<std::mutex> guard(lock);
+	    std::unordered_map<std::string, uint32_t>::iterator found = byName.find(wifi);
+	    if (found == byName.end()) return 0;
+	    for (uint32_t id = 0; id < entries.size(); id++) {
+		const entry & e = entries[id];
+		if (e.live && e.adapter == found->second && e.metric == metric) return e.interval_ms;
+	    }
+	    return 0;
+	}
+};
+#endif
@@ -0,0 +1,539 @@
+/*****************************************************************************************
+* Title: 	iwSim                                                                    *
+* Purpose: 	Simulated virtual-radio backend for iwconfigAPI. It models any number of *
+* 		radios in process and answers the iwconfig/iwgetid command lines built by*
+*		iwconfigAPI with text in the same format as the real tools, so the whole *
+*		API (parsing included) can be exercised without hardware.                *
+*                                                                                        *
+*		Every radio keeps its own configuration, applies the set commands it     *
+*		receives and reports a signal level that wanders around a mean value     *
+*		(Ornstein-Uhlenbeck process). Per command latency, jitter, backend       *
+*		failures and corrupted replies can be injected.                          *
+*		With txpower_coupling set, the reported signal also follows the radio's  *
+*		TX power, a reciprocal link model for testing power control offline.     *
+*		Access points added with addAccessPoint are listed by iwlist scan, and   *
+*		"iwconfig <if> ap <bssid>" to one of them disconnects the radio at once  *
+*		and associates it on a worker thread after assoc_ms, plus                *
+*		channel_search_ms when the radio is not already on the AP's channel.     *
+*		Both steps are published as link events (iwEvents.h).                    *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include "iwconfigAPI.h"
+#include "iwEvents.h"
+#include<atomic>
+#include<chrono>
+#include<condition_variable>
+#include<cmath>
+#include<random>
+#include<thread>
+#include<unordered_map>
+#include<mutex>
+#include<sstream>
+#include<stdio.h>
+#include<string.h>
+#include<strings.h>
+
+/*****************************************************************************************
+* Macros and Constants                                                                   *
+*****************************************************************************************/
+#ifndef _IWSIM
+#define _IWSIM
+
+// Configuration of the simulated radios. Latencies are in microseconds, rates are
+// probabilities between 0 and 1 applied to every command.
+struct iwSimConfig {
+    int radios = 4;              // number of radios: <prefix>0 ... <prefix>N-1
+    std::string prefix = "sim";
+    double latency_us = 0;       // fixed part of every command's latency
+    double jitter_us = 0;        // uniform random extra latency 0..jitter_us
+    double failure_rate = 0;     // command fails with iwBackendFailure
+    double garble_rate = 0;      // digits of the reply are corrupted (parse errors)
+    double signal_mean = -55;    // dBm the signal level reverts to
+    double signal_sigma = 4;     // dBm standard deviation of the signal level
+    double signal_tau_s = 5;     // seconds for the signal level to decorrelate
+    double txpower_coupling = 0; // dB of reported signal per dB of TX power above the reference
+    double txpower_reference = 20; // dBm at which the signal level is signal_mean
+    double scan_ms = 0;          // extra time an iwlist scan takes
+    double assoc_ms = 30;        // association with a known access point
+    double channel_search_ms = 150; // added when the radio is on another channel than the AP
+    unsigned seed = 1;           // radios are seeded seed, seed+1, ..., injection streams from it too
+};
+
+/*****************************************************************************************
+* Simulated Backend                                                                      *
+*****************************************************************************************/
+class iwSimBackend : public iwBackend, public iwLinkEventSource
+{
+   protected:
+	// State of one radio. Mode is the iwgetid --raw --mode number (0 Auto, 1 Ad-Hoc,
+	// 2 Managed, 3 Master, 4 Repeater, 5 Secondary, 6 Monitor).
+	struct radio {
+	    std::mutex lock;
+	    std::string name;
+	    std::string essid = "sim";
+	    bool essidOn = true;
+	    std::string ap = "00:00:00:00:00:00";
+	    int mode = 2;
+	    double freq = 2.437e9;       // Hz
+	    bool txOn = true;
+	    double txpower = 20;         // dBm
+	    double bitrate = 54;         // Mb/s
+	    int rts = 0;                 // bytes, 0 = off
+	    int frag = 0;                // bytes, 0 = off
+	    int retry = 7;
+	    int sens = 0;
+	    double signal = -55;         // dBm
+	    double signalOffset = 0;     // added to the configured mean (see setSignalMean)
+	    std::chrono::steady_clock::time_point signalTime;
+	    std::mt19937 rng;
+	};
+	// Access point that radios can scan for and associate with.
+	struct accessPoint {
+	    std::string bssid;
+	    std::string essid;
+	    int channel;
+	    double signal;               // dBm at the radios
+	};
+	// Association in progress, completed by the worker thread when due.
+	struct association {
+	    radio * r;
+	    accessPoint ap;
+	    std::string from;                 // access point left
+	    std::chrono::steady_clock::time_point start, due;
+	    bool announced;              // disconnect event published
+	};
+	iwSimConfig config;
+	std::vector<std::unique_ptr<radio>> radios;
+	std::unordered_map<std::string, size_t> byName; // read only after construction
+	std::chrono::steady_clock::time_point origin;
+	std::mutex apLock;                         // taken after a radio lock, never before
+	std::vector<accessPoint> accessPoints;
+	std::mutex assocLock;                      // taken after a radio lock, never before
+	std::condition_variable assocWake;
+	std::vector<association> associations;
+	std::thread assocWorker;                   // started by the first association
+	bool stopping = false;
+	uint64_t instance;                    // tells the injection streams of two backends apart
+	std::atomic<unsigned> threadOrdinal;       // threads that have called inject so far
+
+/*****************************************************************************************
+* Find Radio: accepts the interface name with the trailing blank getWIFIList leaves.     *
+*****************************************************************************************/
+	radio * findRadio(const std::string & wifi) const {
+	    size_t end = wifi.find_last_not_of(' ');
+	    std::unordered_map<std::string, size_t>::const_iterator it =
+		byName.find(end == std::string::npos ? wifi : wifi.substr(0, end + 1));
+	    return it == byName.end() ? NULL : radios[it->second].get();
+	}
+
+/*****************************************************************************************
+* Advance Signal: move the signal level of a radio forward to now. Called with the radio *
+* lock held.                                                                             *
+*****************************************************************************************/
+	void advanceSignal(radio & r){
+	    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	    double dt = std::chrono::duration<double>(now - r.signalTime).count();
+	    r.signalTime = now;
+	    if (dt <= 0) return;
+	    double mean = config.signal_mean + r.signalOffset;
+	    double decay = std::exp(-dt / config.signal_tau_s);
+	    std::normal_distribution<double> gauss(0.0, 1.0);
+	    r.signal = mean + (r.signal - mean) * decay
+		+ config.signal_sigma * std::sqrt(1 - decay * decay) * gauss(r.rng);
+	}
+
+	static int channelOf(double freq){
+	    double mhz = freq / 1e6;
+	    if (mhz == 2484) return 14;
+	    if (mhz >= 2412 && mhz < 2484) return (int)((mhz - 2407) / 5 + 0.5);
+	    if (mhz >= 5000 && mhz < 5900) return (int)((mhz - 5000) / 5 + 0.5);
+	    return 0;
+	}
+	static double freqOf(int channel){
+	    if (channel == 14) return 2.484e9;
+	    if (channel < 14) return (2407 + 5 * channel) * 1e6;
+	    return (5000 + 5 * channel) * 1e6;
+	}
+	// A number with an attached unit ("2.412G", "54M"), as iwconfig reads it.
+	static bool withUnit(const std::string & value, double & number){
+	    char * end = NULL;
+	    number = strtod(value.c_str(), &end);
+	    if (end == value.c_str()) return false;
+	    std::string unit(end);
+	    if (unit == "k") number *= 1e3;
+	    else if (unit == "M") number *= 1e6;
+	    else if (unit == "G") number *= 1e9;
+	    else if (!unit.empty()) return false;
+	    return true;
+	}
+	static const char * modeName(int mode){
+	    static const char * names[] = {"Auto", "Ad-Hoc", "Managed", "Master", "Repeater", "Secondary", "Monitor"};
+	    return mode >= 0 && mode <= 6 ? names[mode] : "Auto";
+	}
+
+/*****************************************************************************************
+* Describe: one iwconfig block for a radio, in the layout printed by wireless-tools.     *
+*****************************************************************************************/
+	void describe(radio & r, std::string & data){
+	    char buffer[512];
+	    advanceSignal(r);
+	    std::string essid = r.essidOn ? "\"" + r.essid + "\"" : std::string("off/any");
+	    std::string txpower = r.txOn ? std::to_string((int)std::lround(r.txpower)) + " dBm" : std::string("off");
+	    std::string rts = r.rts > 0 ? std::to_string(r.rts) + " B" : std::string("off");
+	    std::string frag = r.frag > 0 ? std::to_string(r.frag) + " B" : std::string("off");
+	    double signal = r.signal + config.txpower_coupling * ((r.txOn ? r.txpower : 0) - config.txpower_reference);
+	    snprintf(buffer, sizeof buffer,
+		"%-9s IEEE 802.11  ESSID:%s  \n"
+		"          Mode:%s  Frequency:%g GHz  Access Point: %s   \n"
+		"          Bit Rate=%g Mb/s   Tx-Power=%s   \n"
+		"          Retry short limit:%d   RTS thr:%s   Fragment thr:%s\n"
+		"          Power Management:off\n"
+		"          Link Quality=%d/70  Signal level=%d dBm  \n\n",
+		r.name.c_str(), essid.c_str(), modeName(r.mode), r.freq / 1e9, r.ap.c_str(),
+		r.bitrate, txpower.c_str(), r.retry, rts.c_str(), frag.c_str(),
+		std::max(0, std::min(70, (int)std::lround(signal) + 110)), (int)std::lround(signal));
+	    data.append(buffer);
+	}
+
+/*****************************************************************************************
+* Apply: one "iwconfig <if> <param> <value>" command. Called with the radio lock held.   *
+* Unknown parameters are accepted silently, like a driver ignoring them; a frequency or  *
+* bit rate iwconfig cannot read leaves the radio unchanged and prints its error to data. *
+*****************************************************************************************/
+	virtual void apply(radio & r, const std::string & param, const std::string & value, std::string & data){
+	    double number;
+	    if (param == "essid") {
+		r.essidOn = !(value == "off" || value == "any");
+		if (r.essidOn && value != "on") r.essid = value;
+	    }
+	    else if (param == "txpower") {
+		if (value == "off") r.txOn = false;
+		else if (value == "on" || value == "auto") r.txOn = true;
+		else {
+			r.txOn = true;
+			double power = atof(value.c_str());
+			if (value.find("mW") != std::string::npos) power = 10 * std::log10(power);
+			r.txpower = power;
+		}
+	    }
+	    else if (param == "freq") {
+		if (withUnit(value, number)) r.freq = number;
+		else data.append("Error for wireless request \"Set Frequency\" (8B04) :\n    invalid argument \"" + value + "\".\n");
+	    }
+	    else if (param == "channel") {
+		if (value != "auto") r.freq = freqOf(atoi(value.c_str()));
+	    }
+	    else if (param == "mode") {
+		for (int m = 0; m <= 6; m++) {
+			if (value == modeName(m)) r.mode = m;
+		}
+		if (value == "auto") r.mode = 0;
+	    }
+	    else if (param == "ap") {
+		accessPoint target;
+		cancelAssociation(r);
+		if (findAccessPoint(value, target)) associate(r, target);
+		else r.ap = (value == "any" || value == "off") ? std::string("00:00:00:00:00:00") : value;
+	    }
+	    else if (param == "rate") {
+		if (withUnit(value, number)) r.bitrate = number / 1e6;
+		else data.append("Error for wireless request \"Set Bit Rate\" (8B20) :\n    invalid argument \"" + value + "\".\n");
+	    }
+	    else if (param == "rts" || param == "frag") {
+		int & threshold = param == "rts" ? r.rts : r.frag;
+		if (value == "off") threshold = 0;
+		else if (value != "auto" && value != "fixed") threshold = atoi(value.c_str());
+	    }
+	    else if (param == "retry") r.retry = atoi(value.c_str());
+	    else if (param == "sens") r.sens = atoi(value.c_str());
+	}
+
+	bool findAccessPoint(const std::string & bssid, accessPoint & found){
+	    std::lock_guard<std::mutex> guard(apLock);
+	    for (size_t i = 0; i < accessPoints.size(); i++) {
+		if (strcasecmp(accessPoints[i].bssid.c_str(), bssid.c_str()) == 0) {
+			found = accessPoints[i];
+			return true;
+		}
+	    }
+	    return false;
+	}
+	void cancelAssociation(radio & r){
+	    std::lock_guard<std::mutex> guard(assocLock);
+	    for (size_t i = 0; i < associations.size(); i++) {
+		if (associations[i].r == &r) {
+			associations.erase(associations.begin() + i);
+			return;
+		}
+	    }
+	}
+
+/*****************************************************************************************
+* Associate: drop the current link of a radio and queue its association with ap. Called  *
+* with the radio lock held; the events are published by the worker thread.               *
+*****************************************************************************************/
+	void associate(radio & r, const accessPoint & ap){
+	    association a;
+	    a.r = &r;
+	    a.ap = ap;
+	    a.from = r.ap;
+	    a.start = std::chrono::steady_clock::now();
+	    double ms = config.assoc_ms + (channelOf(r.freq) == ap.channel ? 0 : config.channel_search_ms);
+	    a.due = a.start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double, std::milli>(ms));
+	    a.announced = false;
+	    r.ap = "00:00:00:00:00:00";
+	    std::lock_guard<std::mutex> guard(assocLock);
+	    associations.push_back(a);
+	    if (!assocWorker.joinable()) assocWorker = std::thread(&iwSimBackend::completeAssociations, this);
+	    assocWake.notify_one();
+	}
+
+/*****************************************************************************************
+* Complete Associations: worker thread. It announces the disconnection of every queued   *
+* association, then completes each one when due: the radio takes the AP's BSSID, ESSID,  *
+* channel and signal.                                                                    *
+*****************************************************************************************/
+	void completeAssociations(){
+	    std::unique_lock<std::mutex> guard(assocLock);
+	    while (!stopping) {
+		std::vector<iwLinkEvent> events;
+		std::vector<association> done;
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point wake = now + std::chrono::seconds(1);
+		for (size_t i = 0; i < associations.size();) {
+			association & a = associations[i];
+			if (!a.announced) {
+				events.push_back(iwLinkEvent{a.r->name, iwLinkDisconnected, a.from, a.start});
+				a.announced = true;
+			}
+			if (a.due <= now) {
+				done.push_back(a);
+				associations.erase(associations.begin() + i);
+				continue;
+			}
+			wake = std::min(wake, a.due);
+			i++;
+		}
+		if (events.empty() && done.empty()) {
+			assocWake.wait_until(guard, wake);
+			continue;
+		}
+		guard.unlock();
+		for (size_t i = 0; i < done.size(); i++) {
+			radio & r = *done[i].r;
+			{
+			std::lock_guard<std::mutex> radioGuard(r.lock);
+			advanceSignal(r);
+			r.ap = done[i].ap.bssid;
+			r.essid = done[i].ap.essid;
+			r.essidOn = true;
+			r.freq = freqOf(done[i].ap.channel);
+			r.signalOffset = done[i].ap.signal - config.signal_mean;
+			r.signal = done[i].ap.signal;
+			}
+			events.push_back(iwLinkEvent{r.name, iwLinkAssociated, done[i].ap.bssid, std::chrono::steady_clock::now()});
+		}
+		for (size_t i = 0; i < events.size(); i++) publish(events[i]);
+		guard.lock();
+	    }
+	}
+
+/*****************************************************************************************
+* Scan: iwlist scan listing of every access point, in the wireless-tools layout.         *
+*****************************************************************************************/
+	void scan(const std::string & wifi, std::string & data){
+	    std::vector<accessPoint> found;
+	    {
+	    std::lock_guard<std::mutex> guard(apLock);
+	    found = accessPoints;
+	    }
+	    if (found.empty()) {
+		data = wifi + "     No scan results\n\n";
+		return;
+	    }
+	    data = wifi + "     Scan completed :\n";
+	    char buffer[512];
+	    for (size_t i = 0; i < found.size(); i++) {
+		int signal = (int)std::lround(found[i].signal);
+		snprintf(buffer, sizeof buffer,
+			"          Cell %02d - Address: %s\n"
+			"                    Channel:%d\n"
+			"                    Frequency:%g GHz (Channel %d)\n"
+			"                    Quality=%d/70  Signal level=%d dBm  \n"
+			"                    Encryption key:off\n"
+			"                    ESSID:\"%s\"\n"
+			"                    Mode:Master\n",
+			(int)i + 1, found[i].bssid.c_str(), found[i].channel, freqOf(found[i].channel) / 1e9,
+			found[i].channel, std::max(0, std::min(70, signal + 110)), signal, found[i].essid.c_str());
+		data.append(buffer);
+	    }
+	    data.append("\n");
+	}
+
+/*****************************************************************************************
+* Inject: latency, jitter and failures shared by every command. Every thread draws from  *
+* its own stream, derived from the seed and the order in which the threads first called  *
+* this backend, so a run with the same seed and one thread per role repeats itself. A    *
+* thread that alternates between two backends restarts its stream on every switch.       *
+*        output: false if the command must fail                                          *
+*****************************************************************************************/
+	bool inject(bool & garble){
+	    struct stream {
+		uint64_t owner = 0;          // instance the stream was seeded for
+		std::mt19937 rng;
+	    };
+	    static thread_local stream threadStream;
+	    if (threadStream.owner != instance) {
+		std::seed_seq seeds{config.seed, 0x5eedu, threadOrdinal.fetch_add(1)};
+		threadStream.rng.seed(seeds);
+		threadStream.owner = instance;
+	    }
+	    std::mt19937 & threadRng = threadStream.rng;
+	    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	    double delay = config.latency_us + config.jitter_us * uniform(threadRng);
+	    if (delay > 0) std::this_thread::sleep_for(std::chrono::duration<double, std::micro>(delay));
+	    garble = config.garble_rate > 0 && uniform(threadRng) < config.garble_rate;
+	    return !(config.failure_rate > 0 && uniform(threadRng) < config.failure_rate);
+	}
+
+   public:
+	explicit iwSimBackend(const iwSimConfig & simConfig = iwSimConfig())
+		: config(simConfig), origin(std::chrono::steady_clock::now()), threadOrdinal(0) {
+	    static std::atomic<uint64_t> instances(0);
+	    instance = ++instances;
+	    for (int i = 0; i < config.radios; i++) {
+		std::unique_ptr<radio> r(new radio());
+		r->name = config.prefix + std::to_string(i);
+		r->essid = config.prefix;
+		char mac[18];
+		snprintf(mac, sizeof mac, "02:00:00:00:%02x:%02x", (i >> 8) & 0xff, i & 0xff);
+		r->ap = mac;
+		r->freq = freqOf(1 + 5 * (i % 3)); // spread over channels 1, 6 and 11
+		r->rng.seed(config.seed + i);
+		r->signal = config.signal_mean;
+		r->signalTime = origin;
+		byName[r->name] = i;
+		radios.push_back(std::move(r));
+	    }
+	}
+	~iwSimBackend(){
+	    {
+	    std::lock_guard<std::mutex> guard(assocLock);
+	    stopping = true;
+	    assocWake.notify_one();
+	    }
+	    if (assocWorker.joinable()) assocWorker.join();
+	}
+	iwSimBackend(const iwSimBackend &) = delete;
+	iwSimBackend & operator=(const iwSimBackend &) = delete;
+
+	int radioCount() const { return (int)radios.size(); }
+	std::string radioName(int i) const { return radios[i]->name; }
+	// Shift the mean signal level of one radio, e.g. to model a station walking away.
+	void setSignalMean(const std::string & wifi, double dBm){
+	    radio * r = findRadio(wifi);
+	    if (!r) return;
+	    std::lock_guard<std::mutex> guard(r->lock);
+	    advanceSignal(*r);
+	    r->signalOffset = dBm - config.signal_mean;
+	}
+
+/*****************************************************************************************
+* Access Points: add (or move) an access point, remove it from the scans, and change its *
+* signal level. Radios associated with it follow the new level, like a station moving    *
+* away from it.                                                                          *
+*****************************************************************************************/
+	void addAccessPoint(const std::string & bssid, const std::string & essid, int channel, double dBm){
+	    std::lock_guard<std::mutex> guard(apLock);
+	    for (size_t i = 0; i < accessPoints.size(); i++) {
+		if (strcasecmp(accessPoints[i].bssid.c_str(), bssid.c_str()) == 0) {
+			accessPoints[i] = accessPoint{bssid, essid, channel, dBm};
+			return;
+		}
+	    }
+	    accessPoints.push_back(accessPoint{bssid, essid, channel, dBm});
+	}
+	void removeAccessPoint(const std::string & bssid){
+	    std::lock_guard<std::mutex> guard(apLock);
+	    for (size_t i = 0; i < accessPoints.size(); i++) {
+		if (strcasecmp(accessPoints[i].bssid.c_str(), bssid.c_str()) == 0) {
+			accessPoints.erase(accessPoints.begin() + i);
+			return;
+		}
+	    }
+	}
+	void setAccessPointSignal(const std::string & bssid, double dBm){
+	    {
+	    std::lock_guard<std::mutex> guard(apLock);
+	    for (size_t i = 0; i < accessPoints.size(); i++) {
+		if (strcasecmp(accessPoints[i].bssid.c_str(), bssid.c_str()) == 0) accessPoints[i].signal = dBm;
+	    }
+	    }
+	    for (size_t i = 0; i < radios.size(); i++) {
+		std::lock_guard<std::mutex> guard(radios[i]->lock);
+		if (strcasecmp(radios[i]->ap.c_str(), bssid.c_str()) != 0) continue;
+		advanceSignal(*radios[i]);
+		radios[i]->signalOffset = dBm - config.signal_mean;
+	    }
+	}
+
+	iwStatus run(const std::string & cmd, std::string & data) noexcept {
+	    std::istringstream words(cmd);
+	    std::string program, wifi, param, value, next;
+	    words >> program >> wifi >> param >> value >> next;
+	    data.clear();
+	    radio * r = findRadio(wifi);
+	    bool garble;
+	    if (!inject(garble)) return iwBackendFailure;
+	    if (program == "iwconfig" && wifi.empty()) { // list every interface
+		data = "lo        no wireless extensions.\n\n";
+		for (size_t i = 0; i < radios.size(); i++) {
+			std::lock_guard<std::mutex> guard(radios[i]->lock);
+			describe(*radios[i], data);
+		}
+	    }
+	    else if (program == "iwconfig") {
+		if (!r) {
+			data = wifi + "  No such device\n";
+			return iwOK;
+		}
+		std::lock_guard<std::mutex> guard(r->lock);
+		if (param.empty()) describe(*r, data);
+		else {
+			// like iwconfig, a further word is read as the next request, which it is not
+			apply(*r, param, value, data);
+			if (!next.empty()) data.append("Error : unrecognised wireless request \"" + next + "\"\n");
+		}
+	    }
+	    else if (program == "iwlist") {
+		if (!r) {
+			data = wifi + "  Interface doesn't support scanning.\n\n";
+			return iwOK;
+		}
+		if (config.scan_ms > 0) std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(config.scan_ms));
+		scan(r->name, data);
+	    }
+	    else if (program == "iwgetid") {
+		if (!r) return iwOK; // iwgetid prints nothing for unknown interfaces
+		std::lock_guard<std::mutex> guard(r->lock);
+		char buffer[64];
+		if (value == "--freq") snprintf(buffer, sizeof buffer, "%g\n", r->freq);
+		else if (value == "--channel") snprintf(buffer, sizeof buffer, "%d\n", channelOf(r->freq));
+		else if (value == "--mode") snprintf(buffer, sizeof buffer, "%d\n", r->mode);
+		else if (value == "--ap") snprintf(buffer, sizeof buffer, "%s\n", r->ap.c_str());
+		else snprintf(buffer, sizeof buffer, "%s\n", r->essidOn ? r->essid.c_str() : "");
+		data = buffer;
+	    }
+	    else return iwBackendFailure; // not a command this backend knows
+	    if (garble) {
+		for (size_t i = 0; i < data.length(); i++) {
+			if (isdigit((unsigned char)data[i]) || data[i] == '-') data[i] = '?';
+		}
+	    }
+	    return iwOK;
+	}
+};
+#endif
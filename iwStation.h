@@ -0,0 +1,721 @@
+/*****************************************************************************************
+* Title: 	iwStation                                                                *
+* Purpose: 	Per-station table for adapters in Master (AP) mode. The associated       *
+* 		clients are read with an nl80211 station dump (generic netlink, no      *
+*		process spawned) and kept in a flat open addressing table keyed by MAC   *
+*		address. Each refresh is applied incrementally: only stations that were  *
+*		added, changed or removed are handed to the subscribers.                 *
+*                                                                                        *
+*		The table parses the raw netlink dump in place, so a dump saved to a     *
+*		file (iwSaveStationDump) can be replayed offline through the very same   *
+*		code path (iwLoadStationDump + iwStationTable::update). Once the table   *
+*		and the dump buffer have grown to the number of clients, a refresh does  *
+*		not allocate.                                                            *
+*		The same socket class serves the link events of every adapter            *
+*		(iwNl80211Events, an iwLinkEventSource over the "mlme" group).           *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include "iwconfigAPI.h"
+#include "iwEvents.h"
+#include<errno.h>
+#include<poll.h>
+#include<unistd.h>
+#include<net/if.h>
+#include<sys/socket.h>
+#include<linux/netlink.h>
+#include<linux/genetlink.h>
+#include<linux/nl80211.h>
+#include<stdint.h>
+#include<atomic>
+#include<functional>
+#include<mutex>
+#include<thread>
+#include<ctype.h>
+#include<stdio.h>
+#include<string.h>
+
+/*****************************************************************************************
+* Macros and Constants                                                                   *
+*****************************************************************************************/
+#ifndef _IWSTATION
+#define _IWSTATION
+
+// One associated station as reported by NL80211_CMD_GET_STATION. Fields the driver does
+// not report are left at 0.
+struct iwStation {
+    uint8_t mac[6];
+    int signal;             // dBm, last received frame
+    int signalAvg;          // dBm, driver average
+    double txBitrate;       // Mb/s
+    double rxBitrate;       // Mb/s
+    uint64_t rxBytes;
+    uint64_t txBytes;
+    uint32_t rxPackets;
+    uint32_t txPackets;
+    uint32_t txRetries;
+    uint32_t txFailed;
+    uint32_t inactiveMs;
+};
+
+// This enumeration type tells subscribers what happened to a row.
+enum stationChange {stationAdded, stationChanged, stationRemoved};
+
+struct iwStationDelta {
+    stationChange change;
+    iwStation station;      // new values, or the last known values when removed
+};
+
+/*****************************************************************************************
+* Format a MAC address as 00:11:22:33:44:55.                                             *
+*****************************************************************************************/
+inline std::string iwMacString(const uint8_t mac[6]){
+    char buffer[18];
+    snprintf(buffer, sizeof buffer, "%02x:%02x:%02x:%02x:%02x:%02x",
+	     mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    return buffer;
+}
+
+/*****************************************************************************************
+* Netlink attribute walking helpers.                                                     *
+*****************************************************************************************/
+inline const nlattr * iwAttrNext(const nlattr * attr, size_t & remaining){
+    size_t len = NLA_ALIGN(attr->nla_len);
+    remaining = len < remaining ? remaining - len : 0;
+    return (const nlattr *)((const char *)attr + len);
+}
+inline bool iwAttrOk(const nlattr * attr, size_t remaining){
+    return remaining >= sizeof(nlattr) && attr->nla_len >= sizeof(nlattr) && attr->nla_len <= remaining;
+}
+inline const void * iwAttrData(const nlattr * attr){
+    return (const char *)attr + NLA_HDRLEN;
+}
+inline size_t iwAttrLen(const nlattr * attr){
+    return attr->nla_len - NLA_HDRLEN;
+}
+inline uint64_t iwAttrUnsigned(const nlattr * attr){
+    size_t len = iwAttrLen(attr);
+    if (len >= 8) { uint64_t v; memcpy(&v, iwAttrData(attr), 8); return v; }
+    if (len >= 4) { uint32_t v; memcpy(&v, iwAttrData(attr), 4); return v; }
+    if (len >= 2) { uint16_t v; memcpy(&v, iwAttrData(attr), 2); return v; }
+    if (len >= 1) return *(const uint8_t *)iwAttrData(attr);
+    return 0;
+}
+
+/*****************************************************************************************
+* Parse Rate Info: NL80211_STA_INFO_TX_BITRATE / RX_BITRATE nested attribute to Mb/s.    *
+*****************************************************************************************/
+inline double iwParseRateInfo(const nlattr * nested){
+    uint64_t rate16 = 0;
+    uint64_t rate32 = 0;
+    size_t remaining = iwAttrLen(nested);
+    for (const nlattr * attr = (const nlattr *)iwAttrData(nested); iwAttrOk(attr, remaining);
+	 attr = iwAttrNext(attr, remaining)) {
+	int type = attr->nla_type & NLA_TYPE_MASK;
+	if (type == NL80211_RATE_INFO_BITRATE32) rate32 = iwAttrUnsigned(attr);
+	else if (type == NL80211_RATE_INFO_BITRATE) rate16 = iwAttrUnsigned(attr);
+    }
+    return (rate32 ? rate32 : rate16) / 10.0; // 100 kb/s units
+}
+
+/*****************************************************************************************
+* Parse Station Message: one NL80211_CMD_NEW_STATION message of a dump.                  *
+*        output: true if the message carried a station MAC address                       *
+*        input: payload/len - generic netlink payload (after the genlmsghdr)             *
+*****************************************************************************************/
+inline bool iwParseStation(const char * payload, size_t len, iwStation & sta){
+    memset(&sta, 0, sizeof sta);
+    bool haveMac = false;
+    size_t remaining = len;
+    for (const nlattr * attr = (const nlattr *)payload; iwAttrOk(attr, remaining);
+	 attr = iwAttrNext(attr, remaining)) {
+	int type = attr->nla_type & NLA_TYPE_MASK;
+	if (type == NL80211_ATTR_MAC && iwAttrLen(attr) >= 6) {
+		memcpy(sta.mac, iwAttrData(attr), 6);
+		haveMac = true;
+	}
+	else if (type == NL80211_ATTR_STA_INFO) {
+		size_t infoRemaining = iwAttrLen(attr);
+		for (const nlattr * info = (const nlattr *)iwAttrData(attr); iwAttrOk(info, infoRemaining);
+		     info = iwAttrNext(info, infoRemaining)) {
+			switch (info->nla_type & NLA_TYPE_MASK) {
+			    case NL80211_STA_INFO_INACTIVE_TIME: sta.inactiveMs = iwAttrUnsigned(info); break;
+			    case NL80211_STA_INFO_RX_BYTES: if (!sta.rxBytes) sta.rxBytes = iwAttrUnsigned(info); break;
+			    case NL80211_STA_INFO_TX_BYTES: if (!sta.txBytes) sta.txBytes = iwAttrUnsigned(info); break;
+			    case NL80211_STA_INFO_RX_BYTES64: sta.rxBytes = iwAttrUnsigned(info); break;
+			    case NL80211_STA_INFO_TX_BYTES64: sta.txBytes = iwAttrUnsigned(info); break;
+			    case NL80211_STA_INFO_RX_PACKETS: sta.rxPackets = iwAttrUnsigned(info); break;
+			    case NL80211_STA_INFO_TX_PACKETS: sta.txPackets = iwAttrUnsigned(info); break;
+			    case NL80211_STA_INFO_TX_RETRIES: sta.txRetries = iwAttrUnsigned(info); break;
+			    case NL80211_STA_INFO_TX_FAILED: sta.txFailed = iwAttrUnsigned(info); break;
+			    case NL80211_STA_INFO_SIGNAL: sta.signal = (int8_t)iwAttrUnsigned(info); break;
+			    case NL80211_STA_INFO_SIGNAL_AVG: sta.signalAvg = (int8_t)iwAttrUnsigned(info); break;
+			    case NL80211_STA_INFO_TX_BITRATE: sta.txBitrate = iwParseRateInfo(info); break;
+			    case NL80211_STA_INFO_RX_BITRATE: sta.rxBitrate = iwParseRateInfo(info); break;
+			}
+		}
+	}
+    }
+    return haveMac;
+}
+
+/*****************************************************************************************
+* Find Station: the entry of one MAC address in a dump. For an adapter in Managed mode,  *
+* the entry of the associated BSSID (iwNl80211::getBssid) describes the link itself.     *
+*        output: false if the dump holds no such station                                 *
+*****************************************************************************************/
+inline bool iwFindStation(const std::vector<char> & dump, const uint8_t mac[6], iwStation & sta){
+    int remaining = (int)dump.size();
+    for (const nlmsghdr * msg = (const nlmsghdr *)dump.data(); NLMSG_OK(msg, remaining); msg = NLMSG_NEXT(msg, remaining)) {
+	if (msg->nlmsg_len < NLMSG_HDRLEN + GENL_HDRLEN) continue;
+	const char * payload = (const char *)msg + NLMSG_HDRLEN + GENL_HDRLEN;
+	if (iwParseStation(payload, msg->nlmsg_len - NLMSG_HDRLEN - GENL_HDRLEN, sta) && memcmp(sta.mac, mac, 6) == 0)
+		return true;
+    }
+    return false;
+}
+
+/*****************************************************************************************
+* Recorded dumps: the raw bytes returned by iwNl80211::dumpStations, stored as is.       *
+*****************************************************************************************/
+inline bool iwSaveStationDump(const std::string & path, const std::vector<char> & dump){
+    FILE * file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool good = fwrite(dump.data(), 1, dump.size(), file) == dump.size();
+    return fclose(file) == 0 && good;
+}
+inline bool iwLoadStationDump(const std::string & path, std::vector<char> & dump){
+    dump.clear();
+    FILE * file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    char buffer[4096];
+    size_t len;
+    while ((len = fread(buffer, 1, sizeof buffer, file)) > 0) dump.insert(dump.end(), buffer, buffer + len);
+    fclose(file);
+    return true;
+}
+
+/*****************************************************************************************
+* nl80211 Socket: generic netlink socket used to dump the stations of an adapter or to   *
+* listen to one of the nl80211 multicast groups. The nl80211 family id and its groups    *
+* are resolved once when the socket is opened. One object per polling thread; it is not  *
+* safe to share.                                                                         *
+*****************************************************************************************/
+class iwNl80211
+{
+   private:
+	int fd;
+	uint16_t family;
+	uint32_t seq;
+	std::vector<char> receive; // reused receive buffer
+	std::vector<char> reply;   // reused answer of single requests
+	std::vector<std::pair<std::string, uint32_t>> groups; // multicast group names and ids
+
+	// Send one generic netlink request with a single attribute (may be NULL).
+	bool request(uint16_t type, uint16_t flags, uint8_t cmd, uint16_t attrType, const void * attr, size_t attrLen){
+	    char buffer[256];
+	    size_t len = NLMSG_HDRLEN + GENL_HDRLEN + (attr ? NLA_ALIGN(NLA_HDRLEN + attrLen) : 0);
+	    if (len > sizeof buffer) return false;
+	    memset(buffer, 0, len);
+	    nlmsghdr * header = (nlmsghdr *)buffer;
+	    header->nlmsg_len = len;
+	    header->nlmsg_type = type;
+	    header->nlmsg_flags = NLM_F_REQUEST | flags;
+	    header->nlmsg_seq = ++seq;
+	    genlmsghdr * genl = (genlmsghdr *)(buffer + NLMSG_HDRLEN);
+	    genl->cmd = cmd;
+	    genl->version = 1;
+	    if (attr) {
+		nlattr * a = (nlattr *)(buffer + NLMSG_HDRLEN + GENL_HDRLEN);
+		a->nla_len = NLA_HDRLEN + attrLen;
+		a->nla_type = attrType;
+		memcpy((char *)a + NLA_HDRLEN, attr, attrLen);
+	    }
+	    sockaddr_nl kernel;
+	    memset(&kernel, 0, sizeof kernel);
+	    kernel.nl_family = AF_NETLINK;
+	    return sendto(fd, buffer, len, 0, (sockaddr *)&kernel, sizeof kernel) == (ssize_t)len;
+	}
+
+	// Receive the answer to the last request, appending every message to out.
+	// Stops after the first message unless the request was a dump.
+	iwStatus collect(std::vector<char> & out, bool dump){
+	    receive.resize(1 << 15);
+	    for (;;) {
+		int len = recv(fd, receive.data(), receive.size(), 0);
+		if (len < 0 && errno == EINTR) continue;
+		if (len < 0) return iwBackendFailure;
+		for (nlmsghdr * msg = (nlmsghdr *)receive.data(); NLMSG_OK(msg, len); msg = NLMSG_NEXT(msg, len)) {
+			if (msg->nlmsg_seq != seq) continue; // stale answer
+			if (msg->nlmsg_type == NLMSG_DONE) return iwOK;
+			if (msg->nlmsg_type == NLMSG_ERROR) {
+				nlmsgerr * err = (nlmsgerr *)NLMSG_DATA(msg);
+				if (err->error == 0) return iwOK; // acknowledgement
+				return err->error == -ENODEV || err->error == -ENOENT ? iwNotFound : iwBackendFailure;
+			}
+			out.insert(out.end(), (char *)msg, (char *)msg + NLMSG_ALIGN(msg->nlmsg_len));
+			if (!dump) return iwOK;
+		}
+	    }
+	}
+
+	static uint32_t indexOf(const std::string & wifi){
+	    size_t end = wifi.find_last_not_of(' ');
+	    return if_nametoindex(wifi.substr(0, end == std::string::npos ? 0 : end + 1).c_str());
+	}
+
+   public:
+	iwNl80211() : fd(-1), family(0), seq(0) {
+	    fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+	    if (fd < 0) return;
+	    sockaddr_nl local;
+	    memset(&local, 0, sizeof local);
+	    local.nl_family = AF_NETLINK;
+	    if (bind(fd, (sockaddr *)&local, sizeof local) < 0) {
+		close(fd);
+		fd = -1;
+		return;
+	    }
+	    // resolve the nl80211 family id
+	    std::vector<char> answer;
+	    const char name[] = NL80211_GENL_NAME;
+	    if (!request(GENL_ID_CTRL, 0, CTRL_CMD_GETFAMILY, CTRL_ATTR_FAMILY_NAME, name, sizeof name)
+		|| collect(answer, false) != iwOK || answer.size() < NLMSG_HDRLEN + GENL_HDRLEN) return;
+	    nlmsghdr * msg = (nlmsghdr *)answer.data();
+	    size_t remaining = msg->nlmsg_len - NLMSG_HDRLEN - GENL_HDRLEN;
+	    for (const nlattr * attr = (const nlattr *)(answer.data() + NLMSG_HDRLEN + GENL_HDRLEN);
+		 iwAttrOk(attr, remaining); attr = iwAttrNext(attr, remaining)) {
+		int type = attr->nla_type & NLA_TYPE_MASK;
+		if (type == CTRL_ATTR_FAMILY_ID) family = iwAttrUnsigned(attr);
+		else if (type == CTRL_ATTR_MCAST_GROUPS) {
+			// array of nested groups, each with a name and an id
+			size_t groupsRemaining = iwAttrLen(attr);
+			for (const nlattr * group = (const nlattr *)iwAttrData(attr); iwAttrOk(group, groupsRemaining);
+			     group = iwAttrNext(group, groupsRemaining)) {
+				std::string groupName;
+				uint32_t id = 0;
+				size_t fieldRemaining = iwAttrLen(group);
+				for (const nlattr * field = (const nlattr *)iwAttrData(group); iwAttrOk(field, fieldRemaining);
+				     field = iwAttrNext(field, fieldRemaining)) {
+					int fieldType = field->nla_type & NLA_TYPE_MASK;
+					if (fieldType == CTRL_ATTR_MCAST_GRP_ID) id = iwAttrUnsigned(field);
+					else if (fieldType == CTRL_ATTR_MCAST_GRP_NAME && iwAttrLen(field) > 0) {
+						groupName.assign((const char *)iwAttrData(field),
+								 strnlen((const char *)iwAttrData(field), iwAttrLen(field)));
+					}
+				}
+				if (id) groups.push_back(std::make_pair(groupName, id));
+			}
+		}
+	    }
+	}
+	~iwNl80211(){
+	    if (fd >= 0) close(fd);
+	}
+	iwNl80211(const iwNl80211 &) = delete;
+	iwNl80211 & operator=(const iwNl80211 &) = delete;
+	// false if netlink or the nl80211 family is not available
+	bool good() const { return fd >= 0 && family != 0; }
+
+/*****************************************************************************************
+* Dump Stations: raw NL80211_CMD_GET_STATION dump of an adapter.                         *
+*        output: status, dump holds the netlink messages (capacity is kept between calls)*
+*        input: wifi - string containing wifi adapter/interface name.                    *
+*****************************************************************************************/
+	iwStatus dumpStations(const std::string & wifi, std::vector<char> & dump){
+	    dump.clear();
+	    if (!good()) return iwBackendFailure;
+	    uint32_t ifindex = indexOf(wifi);
+	    if (ifindex == 0) return iwNotFound;
+	    if (!request(family, NLM_F_DUMP, NL80211_CMD_GET_STATION, NL80211_ATTR_IFINDEX, &ifindex, sizeof ifindex)) {
+		return iwBackendFailure;
+	    }
+	    return collect(dump, true);
+	}
+
+/*****************************************************************************************
+* Get Interface: type and transmit power of an adapter, from NL80211_CMD_GET_INTERFACE.  *
+*        output: iwOK, iwNotFound if the adapter is missing                              *
+*        input: wifi - string containing wifi adapter/interface name.                    *
+*               iftype - NL80211_IFTYPE_STATION (Managed), NL80211_IFTYPE_AP (Master) ...*
+*               txpower - TX power in dBm, iwNotFound if the driver does not report it   *
+*****************************************************************************************/
+	iwStatus getInterface(const std::string & wifi, uint32_t & iftype, iwResult<double> & txpower){
+	    iftype = NL80211_IFTYPE_UNSPECIFIED;
+	    txpower = iwResult<double>{iwNotFound, -174};
+	    if (!good()) return iwBackendFailure;
+	    uint32_t ifindex = indexOf(wifi);
+	    if (ifindex == 0) return iwNotFound;
+	    if (!request(family, 0, NL80211_CMD_GET_INTERFACE, NL80211_ATTR_IFINDEX, &ifindex, sizeof ifindex)) {
+		return iwBackendFailure;
+	    }
+	    reply.clear();
+	    iwStatus status = collect(reply, false);
+	    if (status != iwOK) return status;
+	    if (reply.size() < NLMSG_HDRLEN + GENL_HDRLEN) return iwNotFound;
+	    const nlmsghdr * msg = (const nlmsghdr *)reply.data();
+	    size_t remaining = msg->nlmsg_len - NLMSG_HDRLEN - GENL_HDRLEN;
+	    for (const nlattr * attr = (const nlattr *)(reply.data() + NLMSG_HDRLEN + GENL_HDRLEN);
+		 iwAttrOk(attr, remaining); attr = iwAttrNext(attr, remaining)) {
+		int type = attr->nla_type & NLA_TYPE_MASK;
+		if (type == NL80211_ATTR_IFTYPE) iftype = iwAttrUnsigned(attr);
+		else if (type == NL80211_ATTR_WIPHY_TX_POWER_LEVEL) {
+			txpower = iwResult<double>{iwOK, (int32_t)iwAttrUnsigned(attr) / 100.0}; // signed mBm
+		}
+	    }
+	    return iwOK;
+	}
+
+/*****************************************************************************************
+* Get BSSID: access point a Managed adapter is associated with, the BSS of the scan      *
+* results (NL80211_CMD_GET_SCAN dump) whose status is associated.                        *
+*        output: iwOK, iwNotFound if the adapter is missing or not associated            *
+*        input: wifi - string containing wifi adapter/interface name.                    *
+*               bssid - MAC address of the access point                                  *
+*****************************************************************************************/
+	iwStatus getBssid(const std::string & wifi, uint8_t bssid[6]){
+	    if (!good()) return iwBackendFailure;
+	    uint32_t ifindex = indexOf(wifi);
+	    if (ifindex == 0) return iwNotFound;
+	    if (!request(family, NLM_F_DUMP, NL80211_CMD_GET_SCAN, NL80211_ATTR_IFINDEX, &ifindex, sizeof ifindex)) {
+		return iwBackendFailure;
+	    }
+	    reply.clear();
+	    iwStatus status = collect(reply, true);
+	    if (status != iwOK) return status;
+	    int messages = (int)reply.size();
+	    for (const nlmsghdr * msg = (const nlmsghdr *)reply.data(); NLMSG_OK(msg, messages); msg = NLMSG_NEXT(msg, messages)) {
+		if (msg->nlmsg_len < NLMSG_HDRLEN + GENL_HDRLEN) continue;
+		size_t remaining = msg->nlmsg_len - NLMSG_HDRLEN - GENL_HDRLEN;
+		for (const nlattr * attr = (const nlattr *)((const char *)msg + NLMSG_HDRLEN + GENL_HDRLEN);
+		     iwAttrOk(attr, remaining); attr = iwAttrNext(attr, remaining)) {
+			if ((attr->nla_type & NLA_TYPE_MASK) != NL80211_ATTR_BSS) continue;
+			const uint8_t * mac = NULL;
+			bool associated = false;
+			size_t bssRemaining = iwAttrLen(attr);
+			for (const nlattr * bss = (const nlattr *)iwAttrData(attr); iwAttrOk(bss, bssRemaining);
+			     bss = iwAttrNext(bss, bssRemaining)) {
+				int type = bss->nla_type & NLA_TYPE_MASK;
+				if (type == NL80211_BSS_BSSID && iwAttrLen(bss) >= 6) mac = (const uint8_t *)iwAttrData(bss);
+				else if (type == NL80211_BSS_STATUS) associated = iwAttrUnsigned(bss) == NL80211_BSS_STATUS_ASSOCIATED;
+			}
+			if (mac && associated) {
+				memcpy(bssid, mac, 6);
+				return iwOK;
+			}
+		}
+	    }
+	    return iwNotFound;
+	}
+
+/*****************************************************************************************
+* Join Group: receive the notifications of an nl80211 multicast group ("mlme" for        *
+* connect, roam and disconnect, "scan" for scan results ...).                            *
+*        output: false if the group does not exist or cannot be joined                   *
+*****************************************************************************************/
+	bool joinGroup(const char * name){
+	    for (size_t i = 0; i < groups.size() && good(); i++) {
+		if (groups[i].first != name) continue;
+		uint32_t id = groups[i].second;
+		return setsockopt(fd, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &id, sizeof id) == 0;
+	    }
+	    return false;
+	}
+
+/*****************************************************************************************
+* Receive Events: wait up to timeout_ms for notifications of the joined groups and       *
+* append every one that arrived to events (capacity is kept between calls).              *
+*        output: iwOK, also when the wait timed out with no event                        *
+*****************************************************************************************/
+	iwStatus receiveEvents(std::vector<char> & events, int timeout_ms){
+	    events.clear();
+	    if (!good()) return iwBackendFailure;
+	    pollfd wait = {fd, POLLIN, 0};
+	    int ready = poll(&wait, 1, timeout_ms);
+	    if (ready < 0 && errno != EINTR) return iwBackendFailure;
+	    if (ready <= 0) return iwOK;
+	    receive.resize(1 << 15);
+	    for (;;) {
+		int len = recv(fd, receive.data(), receive.size(), MSG_DONTWAIT);
+		if (len < 0 && errno == EINTR) continue;
+		if (len < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS ? iwOK : iwBackendFailure;
+		for (nlmsghdr * msg = (nlmsghdr *)receive.data(); NLMSG_OK(msg, len); msg = NLMSG_NEXT(msg, len)) {
+			if (msg->nlmsg_type != family) continue; // acknowledgements, errors
+			events.insert(events.end(), (char *)msg, (char *)msg + NLMSG_ALIGN(msg->nlmsg_len));
+		}
+	    }
+	}
+};
+
+/*****************************************************************************************
+* Station Table: flat open addressing (linear probing) table of stations keyed by the    *
+* 48 bit MAC address. Slots live in one array sized to a power of two and kept at most   *
+* half full; erasing uses backward shift so no tombstones accumulate.                    *
+* update() applies a whole dump as one generation: rows are inserted or overwritten in   *
+* place, rows missing from the dump are removed, and the added/changed/removed rows are  *
+* passed to every subscriber once the generation is complete. By default a row counts as *
+* changed when its signal or a bit rate moved: traffic counters and the inactive time    *
+* change with every frame, so they are kept current in the table without reporting the   *
+* row unless changeCounters is passed to the constructor.                                *
+* update() takes the table's write lock and find()/forEach() its read lock, so readers on*
+* other threads see either the previous or the new generation. Subscribers are called    *
+* after the write lock is released, one generation at a time and in order, so they may   *
+* read the table; they must not update, subscribe or unsubscribe from within the call.   *
+*****************************************************************************************/
+class iwStationTable
+{
+   public:
+	typedef std::function<void(const std::vector<iwStationDelta> &)> subscriber;
+	// Fields of a row whose change reports it as stationChanged.
+	enum {changeSignal = 1, changeBitrate = 2, changeCounters = 4};
+   private:
+	struct slot {
+	    uint64_t key;       // MAC address, 0 = empty (00:00:00:00:00:00 is not a station)
+	    uint32_t seen;      // generation the row was last reported in
+	    iwStation station;
+	};
+	std::vector<slot> slots;
+	size_t used;
+	uint32_t generation;
+	std::vector<iwStationDelta> deltas;  // reused between updates
+	std::vector<iwStationDelta> published; // generation being dispatched, swapped with deltas
+	std::vector<uint64_t> stale;         // reused between updates
+	std::vector<std::pair<uint64_t, subscriber>> subscribers;
+	uint64_t nextId;
+	int changeMask;
+	mutable std::shared_mutex tableLock;
+	std::mutex dispatchLock;             // subscribers and published; taken before tableLock is released
+
+	static uint64_t keyOf(const uint8_t mac[6]){
+	    uint64_t key = 0;
+	    for (int i = 0; i < 6; i++) key = (key << 8) | mac[i];
+	    return key;
+	}
+	size_t home(uint64_t key) const {
+	    return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 20) & (slots.size() - 1);
+	}
+	size_t probe(uint64_t key) const {
+	    size_t i = home(key);
+	    while (slots[i].key != 0 && slots[i].key != key) i = (i + 1) & (slots.size() - 1);
+	    return i;
+	}
+	void rehash(size_t capacity){
+	    std::vector<slot> old(capacity);
+	    old.swap(slots);
+	    for (size_t i = 0; i < old.size(); i++) {
+		if (old[i].key != 0) slots[probe(old[i].key)] = old[i];
+	    }
+	}
+	void erase(uint64_t key){
+	    size_t mask = slots.size() - 1;
+	    size_t i = probe(key);
+	    if (slots[i].key == 0) return;
+	    // backward shift: pull later rows of the cluster into the hole when allowed
+	    size_t j = i;
+	    for (;;) {
+		j = (j + 1) & mask;
+		if (slots[j].key == 0) break;
+		size_t k = home(slots[j].key);
+		bool movable = i <= j ? (k <= i || k > j) : (k <= i && k > j);
+		if (movable) {
+			slots[i] = slots[j];
+			i = j;
+		}
+	    }
+	    slots[i].key = 0;
+	    used--;
+	}
+	bool sameStation(const iwStation & a, const iwStation & b) const {
+	    if ((changeMask & changeSignal) && (a.signal != b.signal || a.signalAvg != b.signalAvg)) return false;
+	    if ((changeMask & changeBitrate) && (a.txBitrate != b.txBitrate || a.rxBitrate != b.rxBitrate)) return false;
+	    if ((changeMask & changeCounters) && (a.rxBytes != b.rxBytes || a.txBytes != b.txBytes
+		|| a.rxPackets != b.rxPackets || a.txPackets != b.txPackets || a.txRetries != b.txRetries
+		|| a.txFailed != b.txFailed || a.inactiveMs != b.inactiveMs)) return false;
+	    return true;
+	}
+	void upsert(const iwStation & sta){
+	    uint64_t key = keyOf(sta.mac);
+	    if (key == 0) return;
+	    if (2 * (used + 1) > slots.size()) rehash(slots.size() * 2);
+	    slot & s = slots[probe(key)];
+	    iwStationDelta delta;
+	    if (s.key == 0) {
+		s.key = key;
+		used++;
+		delta.change = stationAdded;
+	    }
+	    else if (!sameStation(s.station, sta)) delta.change = stationChanged;
+	    else {
+		s.seen = generation;
+		s.station = sta;
+		return;
+	    }
+	    s.seen = generation;
+	    s.station = sta;
+	    delta.station = sta;
+	    deltas.push_back(delta);
+	}
+
+   public:
+	// changes: the changeSignal/changeBitrate/changeCounters fields that report a row.
+	explicit iwStationTable(size_t capacity = 256, int changes = changeSignal | changeBitrate)
+	    : used(0), generation(0), nextId(1), changeMask(changes) {
+	    size_t size = 16;
+	    while (size < 2 * capacity) size *= 2;
+	    slots.resize(size);
+	    deltas.reserve(capacity);
+	    published.reserve(capacity);
+	    stale.reserve(capacity);
+	}
+	iwStationTable(const iwStationTable &) = delete;
+	iwStationTable & operator=(const iwStationTable &) = delete;
+
+	// Subscribers are called from update() with the rows that changed in that generation.
+	// Returns the id to unsubscribe with; unsubscribe() returns once no call is in progress.
+	uint64_t subscribe(subscriber callback){
+	    std::lock_guard<std::mutex> guard(dispatchLock);
+	    subscribers.push_back(std::make_pair(nextId, callback));
+	    return nextId++;
+	}
+	void unsubscribe(uint64_t id){
+	    std::lock_guard<std::mutex> guard(dispatchLock);
+	    for (size_t i = 0; i < subscribers.size(); i++) {
+		if (subscribers[i].first == id) {
+			subscribers.erase(subscribers.begin() + i);
+			return;
+		}
+	    }
+	}
+
+/*****************************************************************************************
+* Update: apply one complete station dump as a new generation.                           *
+*        output: number of rows added, changed or removed                                *
+*        input: dump/len - raw netlink messages from iwNl80211::dumpStations or a file   *
+*****************************************************************************************/
+	size_t update(const char * dump, size_t len){
+	    std::unique_lock<std::shared_mutex> guard(tableLock);
+	    deltas.clear();
+	    generation++;
+	    iwStation sta;
+	    int remaining = (int)len;
+	    for (const nlmsghdr * msg = (const nlmsghdr *)dump; NLMSG_OK(msg, remaining); msg = NLMSG_NEXT(msg, remaining)) {
+		if (msg->nlmsg_len < NLMSG_HDRLEN + GENL_HDRLEN) continue;
+		const char * payload = (const char *)msg + NLMSG_HDRLEN + GENL_HDRLEN;
+		if (iwParseStation(payload, msg->nlmsg_len - NLMSG_HDRLEN - GENL_HDRLEN, sta)) upsert(sta);
+	    }
+	    stale.clear();
+	    for (size_t i = 0; i < slots.size(); i++) {
+		if (slots[i].key != 0 && slots[i].seen != generation) stale.push_back(slots[i].key);
+	    }
+	    for (size_t i = 0; i < stale.size(); i++) {
+		iwStationDelta delta;
+		delta.change = stationRemoved;
+		delta.station = slots[probe(stale[i])].station;
+		deltas.push_back(delta);
+		erase(stale[i]);
+	    }
+	    size_t changed = deltas.size();
+	    if (changed == 0) return 0;
+	    // hand the generation over before releasing the table, so generations are dispatched in order
+	    std::unique_lock<std::mutex> dispatch(dispatchLock);
+	    published.swap(deltas);
+	    guard.unlock();
+	    for (size_t i = 0; i < subscribers.size(); i++) subscribers[i].second(published);
+	    return changed;
+	}
+	size_t update(const std::vector<char> & dump){
+	    return update(dump.data(), dump.size());
+	}
+
+	size_t size() const {
+	    std::shared_lock<std::shared_mutex> guard(tableLock);
+	    return used;
+	}
+	// Copy of one station, false if the MAC address is not in the table.
+	bool find(const uint8_t mac[6], iwStation & sta) const {
+	    std::shared_lock<std::shared_mutex> guard(tableLock);
+	    uint64_t key = keyOf(mac);
+	    if (key == 0) return false;
+	    const slot & s = slots[probe(key)];
+	    if (s.key != key) return false;
+	    sta = s.station;
+	    return true;
+	}
+	// Call visit for every station, in table order, under the read lock.
+	template<typename Visitor>
+	void forEach(Visitor visit) const {
+	    std::shared_lock<std::shared_mutex> guard(tableLock);
+	    for (size_t i = 0; i < slots.size(); i++) {
+		if (slots[i].key != 0) visit(slots[i].station);
+	    }
+	}
+};
+
+/*****************************************************************************************
+* nl80211 Link Events: listens to the nl80211 "mlme" multicast group on a thread of its  *
+* own and publishes connect and roam results as associations (refused ones as failures)  *
+* and disconnect notifications as disconnections. The kernel sends them for every        *
+* association, whatever started it (iwconfig, wpa_supplicant ...).                       *
+*****************************************************************************************/
+class iwNl80211Events : public iwLinkEventSource
+{
+   private:
+	iwNl80211 socket;
+	bool joined;
+	std::atomic<bool> stopping;
+	std::thread reader;
+
+	void parse(const std::vector<char> & events){
+	    int remaining = (int)events.size();
+	    for (const nlmsghdr * msg = (const nlmsghdr *)events.data(); NLMSG_OK(msg, remaining);
+		 msg = NLMSG_NEXT(msg, remaining)) {
+		if (msg->nlmsg_len < NLMSG_HDRLEN + GENL_HDRLEN) continue;
+		const genlmsghdr * genl = (const genlmsghdr *)((const char *)msg + NLMSG_HDRLEN);
+		iwLinkEvent event;
+		if (genl->cmd == NL80211_CMD_CONNECT || genl->cmd == NL80211_CMD_ROAM) event.type = iwLinkAssociated;
+		else if (genl->cmd == NL80211_CMD_DISCONNECT) event.type = iwLinkDisconnected;
+		else continue;
+		event.time = std::chrono::steady_clock::now();
+		uint32_t ifindex = 0;
+		size_t attrRemaining = msg->nlmsg_len - NLMSG_HDRLEN - GENL_HDRLEN;
+		for (const nlattr * attr = (const nlattr *)((const char *)genl + GENL_HDRLEN); iwAttrOk(attr, attrRemaining);
+		     attr = iwAttrNext(attr, attrRemaining)) {
+			int type = attr->nla_type & NLA_TYPE_MASK;
+			if (type == NL80211_ATTR_IFINDEX) ifindex = iwAttrUnsigned(attr);
+			else if (type == NL80211_ATTR_MAC && iwAttrLen(attr) >= 6) {
+				event.bssid = iwMacString((const uint8_t *)iwAttrData(attr));
+				for (size_t i = 0; i < event.bssid.length(); i++) event.bssid[i] = toupper((unsigned char)event.bssid[i]);
+			}
+			else if (type == NL80211_ATTR_STATUS_CODE && iwAttrUnsigned(attr) != 0) event.type = iwLinkFailed;
+			else if (type == NL80211_ATTR_TIMED_OUT) event.type = iwLinkFailed;
+		}
+		char name[IF_NAMESIZE];
+		if (ifindex == 0 || !if_indextoname(ifindex, name)) continue;
+		event.wifi = name;
+		publish(event);
+	    }
+	}
+	void read(){
+	    std::vector<char> events;
+	    while (!stopping.load(std::memory_order_relaxed)) {
+		if (socket.receiveEvents(events, 100) != iwOK)
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		else parse(events);
+	    }
+	}
+
+   public:
+	iwNl80211Events() : joined(false), stopping(false) {
+	    joined = socket.joinGroup("mlme");
+	    if (joined) reader = std::thread(&iwNl80211Events::read, this);
+	}
+	~iwNl80211Events(){
+	    stopping = true;
+	    if (reader.joinable()) reader.join();
+	}
+	// false if nl80211 is not available, then no event is ever published
+	bool good() const { return joined; }
+};
+
+#endif
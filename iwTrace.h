@@ -0,0 +1,282 @@
+/*****************************************************************************************
+* Title: 	iwTrace                                                                  *
+* Purpose: 	Record and replay backends for iwconfigAPI. The recording backend wraps  *
+* 		another backend and writes every command, its output, status and timing  *
+*		to a compact trace file. The replay backend serves the responses of such *
+*		a trace deterministically, either as fast as possible or with the        *
+*		inter-arrival times and latencies observed when it was recorded.         *
+*                                                                                        *
+*		Trace file layout (all integers are unsigned LEB128 varints):            *
+*		    "IWTR" version                                                       *
+*		    record*: start_ns duration_ns status command output                  *
+*		start_ns is relative to the start of the recording. command is either    *
+*		0 followed by length and bytes (a new command, assigned the next index)  *
+*		or index+1 of a command already seen. output is length and bytes.        *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include "iwconfigAPI.h"
+#include<algorithm>
+#include<chrono>
+#include<thread>
+#include<unordered_map>
+#include<stdint.h>
+#include<mutex>
+#include<stdio.h>
+#include<string.h>
+
+/*****************************************************************************************
+* Macros and Constants                                                                   *
+*****************************************************************************************/
+#ifndef _IWTRACE
+#define _IWTRACE
+
+#define IWTRACE_MAGIC "IWTR"
+#define IWTRACE_VERSION 1
+
+// This enumeration type selects how the replay backend paces its responses.
+enum replayMode {replayFast, replayTimed};
+
+// One command captured by the recording backend.
+struct iwTraceRecord {
+    uint64_t start_ns;    // start of the command relative to the start of the recording
+    uint64_t duration_ns; // time the backend took to answer
+    iwStatus status;
+    std::string cmd;
+    std::string output;
+};
+
+/*****************************************************************************************
+* Varint helpers shared by the writer and the reader.                                    *
+*****************************************************************************************/
+inline void iwTracePutVarint(FILE * file, uint64_t value){
+    unsigned char buffer[10];
+    int len = 0;
+    do {
+	buffer[len] = value & 0x7f;
+	value >>= 7;
+	if (value) buffer[len] |= 0x80;
+	len++;
+    } while (value);
+    fwrite(buffer, 1, len, file);
+}
+inline bool iwTraceGetVarint(FILE * file, uint64_t & value){
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+	int c = fgetc(file);
+	if (c == EOF) return false;
+	value |= (uint64_t)(c & 0x7f) << shift;
+	if (!(c & 0x80)) return true;
+    }
+    return false;
+}
+inline bool iwTraceGetBytes(FILE * file, std::string & value){
+    uint64_t len;
+    if (!iwTraceGetVarint(file, len)) return false;
+    // grow with the bytes actually read, so a corrupt length fails at the end of the file
+    // instead of allocating whatever it claims
+    value.clear();
+    char buffer[4096];
+    while (len > 0) {
+	size_t chunk = len < sizeof buffer ? (size_t)len : sizeof buffer;
+	if (fread(buffer, 1, chunk, file) != chunk) return false;
+	value.append(buffer, chunk);
+	len -= chunk;
+    }
+    return true;
+}
+
+/*****************************************************************************************
+* Load Trace: read every record of a trace file.                                         *
+*        output: true if the whole file was read, records holds the commands in order    *
+*                (those read before a corrupt record or an allocation failure)           *
+*        input: path - trace file name                                                   *
+*****************************************************************************************/
+inline bool iwLoadTrace(const std::string & path, std::vector<iwTraceRecord> & records){
+    records.clear();
+    FILE * file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    char magic[4];
+    uint64_t version;
+    bool good = fread(magic, 1, 4, file) == 4 && memcmp(magic, IWTRACE_MAGIC, 4) == 0
+		&& iwTraceGetVarint(file, version) && version == IWTRACE_VERSION;
+    std::vector<std::string> commands;
+    try {
+    while (good) {
+	iwTraceRecord record;
+	uint64_t status, index;
+	if (!iwTraceGetVarint(file, record.start_ns)) break; // clean end of file
+	good = iwTraceGetVarint(file, record.duration_ns) && iwTraceGetVarint(file, status)
+		&& iwTraceGetVarint(file, index);
+	if (!good) break;
+	if (index == 0) { // new command
+		good = iwTraceGetBytes(file, record.cmd);
+		commands.push_back(record.cmd);
+	}
+	else if (index <= commands.size()) {
+		record.cmd = commands[index - 1];
+	}
+	else good = false;
+	good = good && iwTraceGetBytes(file, record.output);
+	if (!good) break;
+	record.status = (iwStatus)status;
+	records.push_back(record);
+    }
+    }
+    catch (...) { // out of memory
+	good = false;
+    }
+    fclose(file);
+    return good;
+}
+
+/*****************************************************************************************
+* Recording Backend: forwards every command to another backend and appends it, with its  *
+* output, status and timing, to a trace file. Records are written under a mutex in the   *
+* order the commands complete. The file is flushed at most every flush interval and by   *
+* flush(), so a crashed recording keeps all but its last moments.                        *
+*****************************************************************************************/
+class iwRecordBackend : public iwBackend
+{
+   private:
+	std::shared_ptr<iwBackend> inner;
+	FILE * file;
+	std::mutex fileMutex;
+	std::unordered_map<std::string, uint64_t> commandIndex;
+	std::chrono::steady_clock::time_point origin, lastFlush;
+	static const int flushInterval_ms = 100;
+   public:
+	iwRecordBackend(std::shared_ptr<iwBackend> recorded, const std::string & path)
+		: inner(recorded), origin(std::chrono::steady_clock::now()), lastFlush(origin) {
+	    file = fopen(path.c_str(), "wb");
+	    if (file) {
+		fwrite(IWTRACE_MAGIC, 1, 4, file);
+		iwTracePutVarint(file, IWTRACE_VERSION);
+	    }
+	}
+	~iwRecordBackend(){
+	    if (file) fclose(file);
+	}
+	iwRecordBackend(const iwRecordBackend &) = delete;
+	iwRecordBackend & operator=(const iwRecordBackend &) = delete;
+	// false if the trace file could not be created
+	bool good() const { return file != NULL; }
+	void flush(){
+	    std::lock_guard<std::mutex> guard(fileMutex);
+	    if (file) fflush(file);
+	}
+	iwStatus run(const std::string & cmd, std::string & data) noexcept {
+	    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	    iwStatus status = inner->run(cmd, data);
+	    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	    if (!file) return status;
+	    std::lock_guard<std::mutex> guard(fileMutex);
+	    iwTracePutVarint(file, std::chrono::duration_cast<std::chrono::nanoseconds>(start - origin).count());
+	    iwTracePutVarint(file, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+	    iwTracePutVarint(file, status);
+	    std::unordered_map<std::string, uint64_t>::iterator known = commandIndex.find(cmd);
+	    if (known != commandIndex.end()) {
+		iwTracePutVarint(file, known->second);
+	    }
+	    else {
+		uint64_t index = commandIndex.size() + 1;
+		commandIndex[cmd] = index;
+		iwTracePutVarint(file, 0);
+		iwTracePutVarint(file, cmd.length());
+		fwrite(cmd.data(), 1, cmd.length(), file);
+	    }
+	    iwTracePutVarint(file, data.length());
+	    fwrite(data.data(), 1, data.length(), file);
+	    if (end - lastFlush >= std::chrono::milliseconds(flushInterval_ms)) {
+		fflush(file);
+		lastFlush = end;
+	    }
+	    return status;
+	}
+};
+
+/*****************************************************************************************
+* Replay Backend: answers commands from a trace. Each distinct command line keeps its own*
+* cursor over the responses recorded for it, so the n-th "iwconfig wlan0" gets the n-th  *
+* recorded answer (wrapping around at the end of the trace) regardless of how calls for  *
+* other commands interleave. The records are put in start order when loaded, since a     *
+* trace recorded by several threads holds them in completion order. In replayTimed mode  *
+* an answer is not given before its recorded start offset (counted from the earliest     *
+* start, at the first command or restart(), plus one trace length per wrap around) and   *
+* then takes the duration it took when recorded, so every user of the backend gets the   *
+* recorded inter-arrival times. Commands that were never recorded fail with              *
+* iwBackendFailure and are counted in misses().                                          *
+*****************************************************************************************/
+class iwReplayBackend : public iwBackend
+{
+   private:
+	struct responses {
+	    std::vector<size_t> records;
+	    mutable std::atomic<size_t> next;
+	};
+	std::vector<iwTraceRecord> trace;
+	std::unordered_map<std::string, std::unique_ptr<responses>> byCommand; // read only after loading
+	replayMode mode;
+	std::atomic<uint64_t> missCount;
+	bool loaded;
+	uint64_t firstStart_ns, span_ns;        // start of the first record, length of the trace
+	std::atomic<int64_t> origin_ns;              // steady clock time of offset 0, 0 until the first command
+   public:
+	iwReplayBackend(const std::string & path, replayMode pace = replayFast)
+		: mode(pace), missCount(0), firstStart_ns(0), span_ns(0), origin_ns(0) {
+	    loaded = iwLoadTrace(path, trace);
+	    std::stable_sort(trace.begin(), trace.end(), [](const iwTraceRecord & a, const iwTraceRecord & b) {
+		return a.start_ns < b.start_ns;
+	    });
+	    if (!trace.empty()) firstStart_ns = trace[0].start_ns;
+	    for (size_t i = 0; i < trace.size(); i++) {
+		span_ns = std::max(span_ns, trace[i].start_ns + trace[i].duration_ns - firstStart_ns);
+		std::unique_ptr<responses> & entry = byCommand[trace[i].cmd];
+		if (!entry) {
+			entry.reset(new responses());
+			entry->next.store(0);
+		}
+		entry->records.push_back(i);
+	    }
+	}
+	// false if the trace could not be read completely (records read so far are used)
+	bool good() const { return loaded; }
+	// The records in start order, records()[0] starts first.
+	const std::vector<iwTraceRecord> & records() const { return trace; }
+	uint64_t firstStart() const { return firstStart_ns; }
+	uint64_t misses() const { return missCount.load(); }
+	// Rewind every command to its first answer and count start offsets from origin.
+	// Call it while no command is in flight.
+	void restart(std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now()){
+	    for (std::unordered_map<std::string, std::unique_ptr<responses>>::iterator it = byCommand.begin();
+		 it != byCommand.end(); ++it)
+		it->second->next.store(0);
+	    origin_ns.store(std::max<int64_t>(1, origin.time_since_epoch().count()));
+	}
+	iwStatus run(const std::string & cmd, std::string & data) noexcept {
+	    std::unordered_map<std::string, std::unique_ptr<responses>>::const_iterator found = byCommand.find(cmd);
+	    if (found == byCommand.end()) {
+		missCount.fetch_add(1, std::memory_order_relaxed);
+		data.clear();
+		return iwBackendFailure;
+	    }
+	    const responses & entry = *found->second;
+	    size_t served = entry.next.fetch_add(1, std::memory_order_relaxed);
+	    const iwTraceRecord & record = trace[entry.records[served % entry.records.size()]];
+	    if (mode == replayTimed) {
+		int64_t origin = origin_ns.load();
+		if (origin == 0) { // the first command starts the clock
+			int64_t now = std::max<int64_t>(1, std::chrono::steady_clock::now().time_since_epoch().count());
+			origin = origin_ns.compare_exchange_strong(origin, now) ? now : origin;
+		}
+		uint64_t offset = (served / entry.records.size()) * span_ns + record.start_ns - firstStart_ns;
+		std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(origin))
+					 + std::chrono::nanoseconds(offset));
+		std::this_thread::sleep_for(std::chrono::nanoseconds(record.duration_ns));
+	    }
+	    data = record.output;
+	    return record.status;
+	}
+};
+#endif
@@ -1,25 +1,198 @@
+
 #include "iwconfigAPI.h"
+#include "iwTrace.h"
+#include<iostream>
+#include<sstream>
+#include<signal.h>
 
 using namespace std;
 
-int main (){
+/*****************************************************************************************
+* usage: iwconfigAPI [--record <trace>] [--apply]                                        *
+*        iwconfigAPI [--record <trace>] --watch <interval> [--format ndjson|csv|bin]     *
+*                    [--fields f1,f2,...] [--output <file>] [--count N]                  *
+*                                                                                        *
+* Without --watch one human readable report of every adapter is printed. --apply first   *
+* applies the demo settings (txpower 23, 5.5 GHz, RTS/Frag auto, retry 24, Managed).     *
+*                                                                                        *
+* --watch samples every adapter each interval (e.g. 100ms, 1s, 2.5, 1m) with a single    *
+* iwconfig command per sample and streams one record per adapter. The schedule is kept on*
+* a fixed grid (start + n * interval) so it never drifts; samples that cannot be taken in*
+* time are skipped and counted on stderr. Output goes through a fixed 64 KiB buffer that *
+* is flushed once per sample, so memory stays bounded however long the watch runs.     *
+*        fields: time interface essid txpower signal frequency channel mode bitrate rts  *
+*                frag retry ap (default: all, time is seconds since the epoch)           *
+*        ndjson: one JSON object per line, unreadable fields are null                    *
+*        csv:    header line then one row per record, unreadable fields are empty        *
+*        bin:    "IWWB" version(u8) nfields(u8) field ids(u8 each), then per record and  *
+*                field, little endian: time i64 microseconds, strings u8 length + bytes, *
+*                numbers u8 status (iwStatus) + f32 (int fields: + i32)                  *
+*****************************************************************************************/
+enum watchFormat {ndjson, csv, bin};
+enum watchField {fTime, fInterface, fEssid, fTxpower, fSignal, fFrequency, fChannel,
+		 fMode, fBitrate, fRts, fFrag, fRetry, fAp, fieldCount};
+static const char * fieldNames[fieldCount] = {"time", "interface", "essid", "txpower", "signal",
+	"frequency", "channel", "mode", "bitrate", "rts", "frag", "retry", "ap"};
 
-   string essid_name;
-   string sap;
-   double Power;
-   double SigLevel;
-   double freq;   
-   double bitrate;   
-   double RTS;   
-   int mode;
-   int chan;
+static volatile sig_atomic_t stopRequested = 0;
+static void requestStop(int){ stopRequested = 1; }
+
+// Interval such as 250ms, 100us, 2s, 1m or a plain number of seconds.
+static bool parseInterval(const string & text, chrono::nanoseconds & period){
+   char * end;
+   double value = strtod(text.c_str(), &end);
+   string unit = end;
+   double scale;
+   if (unit.empty() || unit == "s") scale = 1e9;
+   else if (unit == "ms") scale = 1e6;
+   else if (unit == "us") scale = 1e3;
+   else if (unit == "m") scale = 60e9;
+   else return false;
+   if (end == text.c_str() || value <= 0) return false;
+   period = chrono::nanoseconds((long long)(value * scale));
+   return period.count() > 0;
+}
+
+static void putJSONString(FILE * out, const string & value){
+   fputc('"', out);
+   for (size_t i = 0; i < value.length(); i++) {
+      unsigned char c = value[i];
+      if (c == '"' || c == '\\') { fputc('\\', out); fputc(c, out); }
+      else if (c < 0x20) fprintf(out, "\\u%04x", c);
+      else fputc(c, out);
+   }
+   fputc('"', out);
+}
+
+static void putCSVString(FILE * out, const string & value){
+   if (value.find_first_of(",\"\n") == string::npos) {
+      fputs(value.c_str(), out);
+      return;
+   }
+   fputc('"', out);
+   for (size_t i = 0; i < value.length(); i++) {
+      if (value[i] == '"') fputc('"', out);
+      fputc(value[i], out);
+   }
+   fputc('"', out);
+}
+
+static void putBinaryString(FILE * out, const string & value){
+   unsigned char len = value.length() > 255 ? 255 : (unsigned char)value.length();
+   fputc(len, out);
+   fwrite(value.data(), 1, len, out);
+}
+
+template<typename T>
+static void putBinaryNumber(FILE * out, const iwResult<T> & result){
+   fputc(result.status, out);
+   if (is_integral<T>::value) {
+      int32_t value = (int32_t)result.value;
+      fwrite(&value, sizeof value, 1, out); // little endian hosts only, like the rest of the format
+   }
+   else {
+      float value = (float)result.value;
+      fwrite(&value, sizeof value, 1, out);
+   }
+}
+
+template<typename T>
+static void putNumber(FILE * out, watchFormat format, const iwResult<T> & result){
+   if (format == bin) putBinaryNumber(out, result);
+   else if (result.ok()) fprintf(out, "%.10g", (double)result.value);
+   else if (format == ndjson) fputs("null", out);
+}
+
+static void putString(FILE * out, watchFormat format, const iwResult<string> & result){
+   if (format == bin) {
+      fputc(result.status, out);
+      putBinaryString(out, result.ok() ? result.value : string());
+   }
+   else if (!result.ok()) { if (format == ndjson) fputs("null", out); }
+   else if (format == ndjson) putJSONString(out, result.value);
+   else putCSVString(out, result.value);
+}
 
-   iwconfigAPI wifiAPI;
+static void putRecord(FILE * out, watchFormat format, const vector<int> & fields,
+		      long long timeUs, const iwSnapshot & snap){
+   if (format == ndjson) fputc('{', out);
+   for (size_t i = 0; i < fields.size(); i++) {
+      if (i > 0 && format != bin) fputc(',', out);
+      if (format == ndjson) fprintf(out, "\"%s\":", fieldNames[fields[i]]);
+      switch (fields[i]) {
+	 case fTime:
+	    if (format == bin) fwrite(&timeUs, sizeof timeUs, 1, out);
+	    else fprintf(out, "%lld.%06lld", timeUs / 1000000, timeUs % 1000000);
+	    break;
+	 case fInterface:
+	    if (format == bin) putBinaryString(out, snap.name);
+	    else if (format == ndjson) putJSONString(out, snap.name);
+	    else putCSVString(out, snap.name);
+	    break;
+	 case fEssid: putString(out, format, snap.essid); break;
+	 case fTxpower: putNumber(out, format, snap.txpower); break;
+	 case fSignal: putNumber(out, format, snap.signal); break;
+	 case fFrequency: putNumber(out, format, snap.frequency); break;
+	 case fChannel: putNumber(out, format, snap.channel); break;
+	 case fMode: putNumber(out, format, snap.mode); break;
+	 case fBitrate: putNumber(out, format, snap.bitrate); break;
+	 case fRts: putNumber(out, format, snap.rts); break;
+	 case fFrag: putNumber(out, format, snap.frag); break;
+	 case fRetry: putNumber(out, format, snap.retry); break;
+	 case fAp: putString(out, format, snap.accessPoint); break;
+      }
+   }
+   if (format == ndjson) fputc('}', out);
+   if (format != bin) fputc('\n', out);
+}
 
-    int cnt = wifiAPI.getWIFICount();
-    vector<string> wifi = wifiAPI.getWIFIList();
+static int watch(iwconfigAPI & wifiAPI, chrono::nanoseconds period, watchFormat format,
+		 const vector<int> & fields, FILE * out, long count){
+   static char buffer[1 << 16];
+   setvbuf(out, buffer, _IOFBF, sizeof buffer);
+   if (format == csv) {
+      for (size_t i = 0; i < fields.size(); i++) fprintf(out, i ? ",%s" : "%s", fieldNames[fields[i]]);
+      fputc('\n', out);
+   }
+   else if (format == bin) {
+      fwrite("IWWB", 1, 4, out);
+      fputc(1, out);
+      fputc((int)fields.size(), out);
+      for (size_t i = 0; i < fields.size(); i++) fputc(fields[i], out);
+   }
+   fflush(out);
 
-    for(int i = 0; i < cnt; i++) {
+   vector<iwSnapshot> snaps; // reused every sample
+   long missed = 0;
+   long failed = 0;
+   chrono::steady_clock::time_point next = chrono::steady_clock::now();
+   for (long n = 0; !stopRequested && (count <= 0 || n < count); n++) {
+      long long timeUs = chrono::duration_cast<chrono::microseconds>(
+	 chrono::system_clock::now().time_since_epoch()).count();
+      if (wifiAPI.tryGetSnapshots(snaps) != iwOK) failed++;
+      for (size_t i = 0; i < snaps.size(); i++) putRecord(out, format, fields, timeUs, snaps[i]);
+      if (fflush(out) != 0) break; // reader went away
+      if (count > 0 && n + 1 >= count) break;
+
+      next += period;
+      chrono::steady_clock::time_point now = chrono::steady_clock::now();
+      if (now >= next) { // overran: skip to the next slot on the grid
+	 long behind = (long)((now - next) / period) + 1;
+	 missed += behind;
+	 next += period * behind;
+      }
+      // sleep in short slices so a signal stops the watch promptly
+      while (!stopRequested && chrono::steady_clock::now() < next) {
+	 this_thread::sleep_until(min(next, chrono::steady_clock::now() + chrono::milliseconds(100)));
+      }
+   }
+   fflush(out);
+   if (missed || failed) cerr << "iwconfigAPI: " << missed << " sample(s) skipped, " << failed << " failed\n";
+   return 0;
+}
+
+static void applyDemoSettings(iwconfigAPI & wifiAPI, const vector<string> & wifi){
+   for (size_t i = 0; i < wifi.size(); i++) {
       wifiAPI.setTXPower(wifi[i],on,23);
       wifiAPI.setFrequency(wifi[i],5.5, GHz);
       wifiAPI.setRTS(wifi[i],rtsauto,256);
@@ -30,32 +203,134 @@ int main (){
       //essid_name = "Dummy";
       //essid_name.append(to_string(i));
       //setESSID(wifi[i],essid_name);
+   }
+}
+
+static void report(iwconfigAPI & wifiAPI, const vector<string> & wifi){
+   string essid_name;
+   string sap;
+   double Power;
+   double SigLevel;
+   double freq;
+   double bitrate;
+   double RTS;
+   int mode;
+   int chan;
 
-      essid_name = wifiAPI.getESSID(wifi[i]); 
-      cout << wifi[i] << " ESSID" << i << ": " << essid_name << endl;
-     Power = wifiAPI.getTX_Power(wifi[i]); 
-      cout << wifi[i] << " TXPower" << i << ": " << Power << " dBm" << endl;
-      SigLevel = wifiAPI.getSignalLevel(wifi[i]);  
-      cout << wifi[i] << " Signal_Level" << i << ": " << SigLevel << " dBm" << endl;
+   for (size_t i = 0; i < wifi.size(); i++) {
+      essid_name = wifiAPI.getESSID(wifi[i]);
+      cout << wifi[i] << " ESSID" << i << ": " << essid_name << '\n';
+      Power = wifiAPI.getTX_Power(wifi[i]);
+      cout << wifi[i] << " TXPower" << i << ": " << Power << " dBm" << '\n';
+      SigLevel = wifiAPI.getSignalLevel(wifi[i]);
+      cout << wifi[i] << " Signal_Level" << i << ": " << SigLevel << " dBm" << '\n';
       freq = wifiAPI.getFrequency(wifi[i]);
-      cout << wifi[i] << " Frequency" << i << ": " << freq << " Hz" << endl;
+      cout << wifi[i] << " Frequency" << i << ": " << freq << " Hz" << '\n';
       chan = wifiAPI.getChannel(wifi[i]);
-      cout << wifi[i] << " Channel" << i << ": " << chan << endl;
+      cout << wifi[i] << " Channel" << i << ": " << chan << '\n';
       mode = wifiAPI.getMode(wifi[i]);
-      cout << wifi[i] << " Mode" << i << ": " << mode << endl;
-      bitrate = wifiAPI.getBitRate(wifi[i]); 
-     cout << wifi[i] << " Bit Rate" << i << ": " << bitrate << endl;
-      RTS = wifiAPI.getRTS(wifi[i]); 
-     cout << wifi[i] << " RTS" << i << ": " << RTS << endl;
-      RTS = wifiAPI.getFrag(wifi[i]); 
-     cout << wifi[i] << " Frag" << i << ": " << RTS << endl;
-     sap = wifiAPI.getAccessPoint(wifi[i]);
-      cout << wifi[i] << " ap" << i << ": " << sap << endl;
+      cout << wifi[i] << " Mode" << i << ": " << mode << '\n';
+      bitrate = wifiAPI.getBitRate(wifi[i]);
+      cout << wifi[i] << " Bit Rate" << i << ": " << bitrate << '\n';
+      RTS = wifiAPI.getRTS(wifi[i]);
+      cout << wifi[i] << " RTS" << i << ": " << RTS << '\n';
+      RTS = wifiAPI.getFrag(wifi[i]);
+      cout << wifi[i] << " Frag" << i << ": " << RTS << '\n';
+      sap = wifiAPI.getAccessPoint(wifi[i]);
+      cout << wifi[i] << " ap" << i << ": " << sap << '\n';
       RTS = wifiAPI.getRetry(wifi[i]);
-     cout << wifi[i] << " Retry" << i << ": " << RTS << endl;
-    }
-  
-  return 0;
-    }
+      cout << wifi[i] << " Retry" << i << ": " << RTS << '\n';
+   }
+   cout.flush();
+}
+
+static int usage(){
+   cerr << "usage: iwconfigAPI [--record <trace>] [--apply]\n"
+	   "       iwconfigAPI [--record <trace>] --watch <interval> [--format ndjson|csv|bin]\n"
+	   "                   [--fields f1,f2,...] [--output <file>] [--count N]\n";
+   return 2;
+}
+
+int main (int argc, char ** argv){
+   string tracePath;
+   string outputPath;
+   bool apply = false;
+   bool watching = false;
+   chrono::nanoseconds period(0);
+   watchFormat format = ndjson;
+   vector<int> fields;
+   long count = 0;
+
+   for (int i = 1; i < argc; i++) {
+      string arg = argv[i];
+      bool hasValue = i + 1 < argc;
+      if (arg == "--apply") apply = true;
+      else if (arg == "--record" && hasValue) tracePath = argv[++i];
+      else if (arg == "--output" && hasValue) outputPath = argv[++i];
+      else if (arg == "--count" && hasValue) count = atol(argv[++i]);
+      else if (arg == "--watch" && hasValue) {
+	 watching = true;
+	 if (!parseInterval(argv[++i], period)) {
+	    cerr << "invalid interval " << argv[i] << '\n';
+	    return usage();
+	 }
+      }
+      else if (arg == "--format" && hasValue) {
+	 string name = argv[++i];
+	 if (name == "ndjson") format = ndjson;
+	 else if (name == "csv") format = csv;
+	 else if (name == "bin") format = bin;
+	 else return usage();
+      }
+      else if (arg == "--fields" && hasValue) {
+	 istringstream list(argv[++i]);
+	 string name;
+	 while (getline(list, name, ',')) {
+	    int field = 0;
+	    while (field < fieldCount && name != fieldNames[field]) field++;
+	    if (field == fieldCount) {
+	       cerr << "unknown field " << name << '\n';
+	       return usage();
+	    }
+	    fields.push_back(field);
+	 }
+      }
+      else return usage();
+   }
+   if (fields.empty()) {
+      for (int field = 0; field < fieldCount; field++) fields.push_back(field);
+   }
+
+   // --record <trace> captures every command issued below for iwreplay.
+   shared_ptr<iwBackend> backend = make_shared<iwShellBackend>();
+   if (!tracePath.empty()) {
+      shared_ptr<iwRecordBackend> recorder = make_shared<iwRecordBackend>(backend, tracePath);
+      if (!recorder->good()) {
+	 cerr << "cannot create trace " << tracePath << '\n';
+	 return 1;
+      }
+      backend = recorder;
+   }
+   iwconfigAPI wifiAPI(backend);
+
+   if (apply) applyDemoSettings(wifiAPI, wifiAPI.getWIFIList());
+   if (!watching) {
+      report(wifiAPI, wifiAPI.getWIFIList());
+      return 0;
+   }
 
- 
+   FILE * out = stdout;
+   if (!outputPath.empty()) {
+      out = fopen(outputPath.c_str(), format == bin ? "wb" : "w");
+      if (!out) {
+	 cerr << "cannot open " << outputPath << '\n';
+	 return 1;
+      }
+   }
+   signal(SIGINT, requestStop);
+   signal(SIGTERM, requestStop);
+   signal(SIGPIPE, SIG_IGN); // a closed pipe shows up as a failed fflush
+   int rc = watch(wifiAPI, period, format, fields, out, count);
+   if (out != stdout) fclose(out);
+   return rc;
+}
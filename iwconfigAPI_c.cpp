@@ -0,0 +1,229 @@
+/*****************************************************************************************
+* Title: 	iwconfigAPI C interface                                                  *
+* Purpose: 	Implementation of iwconfigAPI_c.h on top of the iwconfigAPI class. Every *
+*		entry point catches all exceptions and converts them to a status.        *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include "iwconfigAPI.h"
+#include "iwconfigAPI_c.h"
+#include<mutex>
+#include<string.h>
+
+using namespace std;
+
+struct iwconfig_handle {
+    iwconfigAPI api;
+    vector<iwSnapshot> snaps; // reused by iwconfig_get_snapshots
+    mutex snapsLock;
+};
+
+static_assert((int)IWCONFIG_BACKEND_FAILURE == (int)iwBackendFailure, "iwconfig_status must extend iwStatus");
+static_assert((int)IWCONFIG_METRIC_COUNT == (int)metricCount, "iwconfig_metric must match iwMetric");
+static_assert((int)IWCONFIG_TX_MW == (int)mW && (int)IWCONFIG_UNIT_GHZ == (int)GHz
+	      && (int)IWCONFIG_AUTOMATIC == (int)Automatic && (int)IWCONFIG_THR_BYTES == (int)rtsbyte,
+	      "setter enumerations must match iwconfigAPI.h");
+
+// Copy a string into a caller buffer, truncating it.
+static iwconfig_status copyString(const string & value, char * buffer, size_t size){
+    if (size == 0) return IWCONFIG_TRUNCATED;
+    size_t len = value.length() < size ? value.length() : size - 1;
+    memcpy(buffer, value.data(), len);
+    buffer[len] = '\0';
+    return len == value.length() ? IWCONFIG_OK : IWCONFIG_TRUNCATED;
+}
+
+static void copySnapshot(const iwSnapshot & from, iwconfig_snapshot & to){
+    copyString(from.name, to.name, sizeof(to.name));
+    copyString(from.essid.value, to.essid, sizeof(to.essid));
+    copyString(from.accessPoint.value, to.access_point, sizeof(to.access_point));
+    to.txpower = from.txpower.value;
+    to.signal = from.signal.value;
+    to.frequency = from.frequency.value;
+    to.channel = from.channel.value;
+    to.mode = from.mode.value;
+    to.bitrate = from.bitrate.value;
+    to.rts = from.rts.value;
+    to.frag = from.frag.value;
+    to.retry = from.retry.value;
+    to.status[IWCONFIG_ESSID] = from.essid.status;
+    to.status[IWCONFIG_TXPOWER] = from.txpower.status;
+    to.status[IWCONFIG_SIGNAL] = from.signal.status;
+    to.status[IWCONFIG_FREQUENCY] = from.frequency.status;
+    to.status[IWCONFIG_CHANNEL] = from.channel.status;
+    to.status[IWCONFIG_MODE] = from.mode.status;
+    to.status[IWCONFIG_BITRATE] = from.bitrate.status;
+    to.status[IWCONFIG_RTS] = from.rts.status;
+    to.status[IWCONFIG_FRAG] = from.frag.status;
+    to.status[IWCONFIG_RETRY] = from.retry.status;
+    to.status[IWCONFIG_ACCESS_POINT] = from.accessPoint.status;
+}
+
+// Runs a setter and returns its status, mapping any exception to a backend failure.
+template<typename Set> static iwconfig_status applySetting(iwconfig_handle * handle, const char * wifi, Set set){
+    if (!handle || !wifi) return IWCONFIG_INVALID_ARGUMENT;
+    try {
+	return (iwconfig_status)set(handle->api, string(wifi));
+    }
+    catch (...) {
+	return IWCONFIG_BACKEND_FAILURE;
+    }
+}
+
+/*****************************************************************************************
+* Handle                                                                                 *
+*****************************************************************************************/
+iwconfig_handle * iwconfig_open(void){
+    try {
+	return new iwconfig_handle();
+    }
+    catch (...) { // out of memory, or the constructor failed (backend, lock table ...)
+	return NULL;
+    }
+}
+
+void iwconfig_close(iwconfig_handle * handle){
+    delete handle;
+}
+
+const char * iwconfig_status_string(iwconfig_status status){
+    switch (status) {
+	case IWCONFIG_INVALID_ARGUMENT: return "invalid-argument";
+	case IWCONFIG_TRUNCATED: return "truncated";
+	default: {
+	    iwResult<int> result = {(iwStatus)status, 0};
+	    return result.reason();
+	}
+    }
+}
+
+/*****************************************************************************************
+* Getters                                                                                *
+*****************************************************************************************/
+iwconfig_status iwconfig_get_snapshot(iwconfig_handle * handle, const char * wifi, iwconfig_snapshot * snap){
+    if (!handle || !wifi || !snap) return IWCONFIG_INVALID_ARGUMENT;
+    try {
+	iwSnapshot data;
+	iwStatus status = handle->api.tryGetSnapshot(wifi, data);
+	if (status != iwOK) return (iwconfig_status)status;
+	copySnapshot(data, *snap);
+	return IWCONFIG_OK;
+    }
+    catch (...) {
+	return IWCONFIG_BACKEND_FAILURE;
+    }
+}
+
+iwconfig_status iwconfig_get_snapshots(iwconfig_handle * handle, iwconfig_snapshot * snaps, size_t capacity,
+				       size_t * count){
+    if (!handle || !count || (!snaps && capacity)) return IWCONFIG_INVALID_ARGUMENT;
+    lock_guard<mutex> guard(handle->snapsLock);
+    iwStatus status = handle->api.tryGetSnapshots(handle->snaps);
+    *count = handle->snaps.size();
+    if (status != iwOK) return (iwconfig_status)status;
+    for (size_t i = 0; i < handle->snaps.size() && i < capacity; i++) copySnapshot(handle->snaps[i], snaps[i]);
+    return handle->snaps.size() > capacity ? IWCONFIG_TRUNCATED : IWCONFIG_OK;
+}
+
+iwconfig_status iwconfig_get_number(iwconfig_handle * handle, const char * wifi, iwconfig_metric metric, double * value){
+    if (!handle || !wifi || !value) return IWCONFIG_INVALID_ARGUMENT;
+    try {
+	iwconfigAPI & api = handle->api;
+	string name(wifi);
+	iwResult<double> result = {iwOK, 0};
+	iwResult<int> whole = {iwOK, 0};
+	switch (metric) {
+	    case IWCONFIG_TXPOWER: result = api.tryGetTX_Power(name); break;
+	    case IWCONFIG_SIGNAL: result = api.tryGetSignalLevel(name); break;
+	    case IWCONFIG_FREQUENCY: result = api.tryGetFrequency(name); break;
+	    case IWCONFIG_BITRATE: result = api.tryGetBitRate(name); break;
+	    case IWCONFIG_RTS: result = api.tryGetRTS(name); break;
+	    case IWCONFIG_FRAG: result = api.tryGetFrag(name); break;
+	    case IWCONFIG_CHANNEL: whole = api.tryGetChannel(name); break;
+	    case IWCONFIG_MODE: whole = api.tryGetMode(name); break;
+	    case IWCONFIG_RETRY: whole = api.tryGetRetry(name); break;
+	    default: return IWCONFIG_INVALID_ARGUMENT;
+	}
+	if (metric == IWCONFIG_CHANNEL || metric == IWCONFIG_MODE || metric == IWCONFIG_RETRY) {
+	    result.status = whole.status;
+	    result.value = whole.value;
+	}
+	*value = result.value;
+	return (iwconfig_status)result.status;
+    }
+    catch (...) {
+	return IWCONFIG_BACKEND_FAILURE;
+    }
+}
+
+iwconfig_status iwconfig_get_string(iwconfig_handle * handle, const char * wifi, iwconfig_metric metric,
+				    char * buffer, size_t size){
+    if (!handle || !wifi || !buffer) return IWCONFIG_INVALID_ARGUMENT;
+    try {
+	iwResult<string> result;
+	if (metric == IWCONFIG_ESSID) result = handle->api.tryGetESSID(wifi);
+	else if (metric == IWCONFIG_ACCESS_POINT) result = handle->api.tryGetAccessPoint(wifi);
+	else return IWCONFIG_INVALID_ARGUMENT;
+	iwconfig_status copied = copyString(result.value, buffer, size);
+	return result.ok() ? copied : (iwconfig_status)result.status;
+    }
+    catch (...) {
+	return IWCONFIG_BACKEND_FAILURE;
+    }
+}
+
+/*****************************************************************************************
+* Setters                                                                                *
+*****************************************************************************************/
+iwconfig_status iwconfig_set_essid(iwconfig_handle * handle, const char * wifi, const char * essid){
+    if (!essid) return IWCONFIG_INVALID_ARGUMENT;
+    return applySetting(handle, wifi, [essid](iwconfigAPI & api, const string & name) { return api.setESSID(name, essid); });
+}
+
+iwconfig_status iwconfig_set_txpower(iwconfig_handle * handle, const char * wifi, iwconfig_tx_mode mode, int value){
+    if (mode < IWCONFIG_TX_AUTO || mode > IWCONFIG_TX_MW) return IWCONFIG_INVALID_ARGUMENT;
+    return applySetting(handle, wifi, [=](iwconfigAPI & api, const string & name) { return api.setTXPower(name, (txMode)mode, value); });
+}
+
+iwconfig_status iwconfig_set_sensitivity(iwconfig_handle * handle, const char * wifi, int value){
+    return applySetting(handle, wifi, [=](iwconfigAPI & api, const string & name) { return api.setSensitivity(name, value); });
+}
+
+iwconfig_status iwconfig_set_frequency(iwconfig_handle * handle, const char * wifi, double value, iwconfig_unit unit){
+    if (unit < IWCONFIG_UNIT_RAW || unit > IWCONFIG_UNIT_GHZ) return IWCONFIG_INVALID_ARGUMENT;
+    return applySetting(handle, wifi, [=](iwconfigAPI & api, const string & name) { return api.setFrequency(name, value, (fUnits)unit); });
+}
+
+iwconfig_status iwconfig_set_channel(iwconfig_handle * handle, const char * wifi, int channel){
+    return applySetting(handle, wifi, [=](iwconfigAPI & api, const string & name) { return api.setChannel(name, channel); });
+}
+
+iwconfig_status iwconfig_set_mode(iwconfig_handle * handle, const char * wifi, iwconfig_mode mode){
+    if (mode < IWCONFIG_ADHOC || mode > IWCONFIG_AUTOMATIC) return IWCONFIG_INVALID_ARGUMENT;
+    return applySetting(handle, wifi, [=](iwconfigAPI & api, const string & name) { return api.setMode(name, (mMode)mode); });
+}
+
+iwconfig_status iwconfig_set_access_point(iwconfig_handle * handle, const char * wifi, const char * ap){
+    if (!ap) return IWCONFIG_INVALID_ARGUMENT;
+    return applySetting(handle, wifi, [ap](iwconfigAPI & api, const string & name) { return api.setAccessPoint(name, ap); });
+}
+
+iwconfig_status iwconfig_set_bitrate(iwconfig_handle * handle, const char * wifi, double value, iwconfig_unit unit){
+    if (unit < IWCONFIG_UNIT_RAW || unit > IWCONFIG_UNIT_GHZ) return IWCONFIG_INVALID_ARGUMENT;
+    return applySetting(handle, wifi, [=](iwconfigAPI & api, const string & name) { return api.setBitRate(name, value, (fUnits)unit); });
+}
+
+iwconfig_status iwconfig_set_rts(iwconfig_handle * handle, const char * wifi, iwconfig_threshold_mode mode, int value){
+    if (mode < IWCONFIG_THR_AUTO || mode > IWCONFIG_THR_BYTES) return IWCONFIG_INVALID_ARGUMENT;
+    return applySetting(handle, wifi, [=](iwconfigAPI & api, const string & name) { return api.setRTS(name, (RTSmode)mode, value); });
+}
+
+iwconfig_status iwconfig_set_frag(iwconfig_handle * handle, const char * wifi, iwconfig_threshold_mode mode, int value){
+    if (mode < IWCONFIG_THR_AUTO || mode > IWCONFIG_THR_BYTES) return IWCONFIG_INVALID_ARGUMENT;
+    return applySetting(handle, wifi, [=](iwconfigAPI & api, const string & name) { return api.setFrag(name, (RTSmode)mode, value); });
+}
+
+iwconfig_status iwconfig_set_retry(iwconfig_handle * handle, const char * wifi, int value){
+    return applySetting(handle, wifi, [=](iwconfigAPI & api, const string & name) { return api.setRetry(name, value); });
+}
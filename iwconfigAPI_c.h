@@ -0,0 +1,136 @@
+/*****************************************************************************************
+* Title: 	iwconfigAPI C interface                                                  *
+* Purpose: 	Stable C ABI of libiwconfigapi for tools that are not written in C++.    *
+*		An iwconfig_handle is an opaque iwconfigAPI object; every function       *
+*		returns an iwconfig_status and never lets a C++ exception escape.        *
+*		Values are copied into caller owned memory, so no C++ object or string   *
+*		ever crosses the interface. Strings are NUL terminated and truncated to  *
+*		the buffer, reported as IWCONFIG_TRUNCATED.                              *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include<stddef.h>
+
+/*****************************************************************************************
+* Macros and Constants                                                                   *
+*****************************************************************************************/
+#ifndef _IWCONFIGAPI_C
+#define _IWCONFIGAPI_C
+
+#if defined(__GNUC__)
+#define IWCONFIG_C_EXPORT __attribute__((visibility("default")))
+#else
+#define IWCONFIG_C_EXPORT
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Outcome of every call. The first five match iwStatus.
+typedef enum {
+    IWCONFIG_OK = 0,
+    IWCONFIG_NOT_FOUND = 1,
+    IWCONFIG_OFF = 2,
+    IWCONFIG_PARSE_ERROR = 3,
+    IWCONFIG_BACKEND_FAILURE = 4,
+    IWCONFIG_INVALID_ARGUMENT = 5,  // NULL handle, name or buffer, or a value out of range
+    IWCONFIG_TRUNCATED = 6          // the result did not fit the caller's buffer
+} iwconfig_status;
+
+// Snapshot fields, same numbering as iwMetric.
+typedef enum {
+    IWCONFIG_ESSID, IWCONFIG_TXPOWER, IWCONFIG_SIGNAL, IWCONFIG_FREQUENCY, IWCONFIG_CHANNEL,
+    IWCONFIG_MODE, IWCONFIG_BITRATE, IWCONFIG_RTS, IWCONFIG_FRAG, IWCONFIG_RETRY,
+    IWCONFIG_ACCESS_POINT, IWCONFIG_METRIC_COUNT
+} iwconfig_metric;
+
+// Setter modes and units, same numbering as txMode, fUnits, mMode and RTSmode.
+typedef enum {IWCONFIG_TX_AUTO, IWCONFIG_TX_OFF, IWCONFIG_TX_ON, IWCONFIG_TX_DBM, IWCONFIG_TX_MW} iwconfig_tx_mode;
+typedef enum {IWCONFIG_UNIT_RAW, IWCONFIG_UNIT_KHZ, IWCONFIG_UNIT_MHZ, IWCONFIG_UNIT_GHZ} iwconfig_unit;
+typedef enum {IWCONFIG_ADHOC, IWCONFIG_MANAGED, IWCONFIG_MASTER, IWCONFIG_REPEATER, IWCONFIG_SECONDARY,
+	      IWCONFIG_MONITOR, IWCONFIG_AUTOMATIC} iwconfig_mode;
+typedef enum {IWCONFIG_THR_AUTO, IWCONFIG_THR_OFF, IWCONFIG_THR_FIXED, IWCONFIG_THR_BYTES} iwconfig_threshold_mode;
+
+// Every field of one adapter, filled from a single iwconfig command. status holds one
+// iwconfig_status per iwconfig_metric; fields that could not be read keep the defaults
+// of the C++ getters (-174 dBm, 0, "off/any", "No Access Point").
+typedef struct {
+    char name[32];
+    char essid[33];
+    char access_point[18];
+    double txpower;     // dBm
+    double signal;      // dBm
+    double frequency;   // Hz
+    int channel;
+    int mode;           // iwgetid numbering: 0 Auto, 1 Ad-Hoc, 2 Managed, 3 Master ...
+    double bitrate;     // Mb/s
+    double rts;         // bytes
+    double frag;        // bytes
+    int retry;
+    int status[IWCONFIG_METRIC_COUNT];
+} iwconfig_snapshot;
+
+typedef struct iwconfig_handle iwconfig_handle;
+
+/*****************************************************************************************
+* Open/Close: create an iwconfigAPI object running iwconfig/iwgetid through the shell,   *
+* and destroy it. A handle may be shared by several threads, like the C++ object.        *
+*        output: new handle, NULL when out of memory or the object could not be created  *
+*****************************************************************************************/
+IWCONFIG_C_EXPORT iwconfig_handle * iwconfig_open(void);
+IWCONFIG_C_EXPORT void iwconfig_close(iwconfig_handle * handle);
+
+// Readable name of a status ("ok", "not-found" ...).
+IWCONFIG_C_EXPORT const char * iwconfig_status_string(iwconfig_status status);
+
+/*****************************************************************************************
+* Snapshots: read one adapter, or every wireless adapter with a single command. When     *
+* there are more adapters than capacity, the first capacity are copied, count holds the  *
+* total and IWCONFIG_TRUNCATED is returned.                                              *
+*****************************************************************************************/
+IWCONFIG_C_EXPORT iwconfig_status iwconfig_get_snapshot(iwconfig_handle * handle, const char * wifi,
+							 iwconfig_snapshot * snap);
+IWCONFIG_C_EXPORT iwconfig_status iwconfig_get_snapshots(iwconfig_handle * handle, iwconfig_snapshot * snaps,
+							  size_t capacity, size_t * count);
+
+/*****************************************************************************************
+* Single field getters, mapped to the exception free tryGet functions.                   *
+* iwconfig_get_number accepts every metric but the two strings, iwconfig_get_string only *
+* IWCONFIG_ESSID and IWCONFIG_ACCESS_POINT.                                              *
+*****************************************************************************************/
+IWCONFIG_C_EXPORT iwconfig_status iwconfig_get_number(iwconfig_handle * handle, const char * wifi,
+						       iwconfig_metric metric, double * value);
+IWCONFIG_C_EXPORT iwconfig_status iwconfig_get_string(iwconfig_handle * handle, const char * wifi,
+						       iwconfig_metric metric, char * buffer, size_t size);
+
+/*****************************************************************************************
+* Setters: same commands as the C++ setters, with their status: IWCONFIG_OK once         *
+* iwconfig accepted the setting, IWCONFIG_NOT_FOUND for a missing adapter,               *
+* IWCONFIG_PARSE_ERROR when iwconfig or the driver rejected the value, and               *
+* IWCONFIG_BACKEND_FAILURE when the command could not be executed.                       *
+*****************************************************************************************/
+IWCONFIG_C_EXPORT iwconfig_status iwconfig_set_essid(iwconfig_handle * handle, const char * wifi, const char * essid);
+IWCONFIG_C_EXPORT iwconfig_status iwconfig_set_txpower(iwconfig_handle * handle, const char * wifi,
+							iwconfig_tx_mode mode, int value);
+IWCONFIG_C_EXPORT iwconfig_status iwconfig_set_sensitivity(iwconfig_handle * handle, const char * wifi, int value);
+IWCONFIG_C_EXPORT iwconfig_status iwconfig_set_frequency(iwconfig_handle * handle, const char * wifi, double value,
+							  iwconfig_unit unit);
+IWCONFIG_C_EXPORT iwconfig_status iwconfig_set_channel(iwconfig_handle * handle, const char * wifi, int channel);
+IWCONFIG_C_EXPORT iwconfig_status iwconfig_set_mode(iwconfig_handle * handle, const char * wifi, iwconfig_mode mode);
+IWCONFIG_C_EXPORT iwconfig_status iwconfig_set_access_point(iwconfig_handle * handle, const char * wifi,
+							     const char * ap);
+IWCONFIG_C_EXPORT iwconfig_status iwconfig_set_bitrate(iwconfig_handle * handle, const char * wifi, double value,
+							iwconfig_unit unit);
+IWCONFIG_C_EXPORT iwconfig_status iwconfig_set_rts(iwconfig_handle * handle, const char * wifi,
+						    iwconfig_threshold_mode mode, int value);
+IWCONFIG_C_EXPORT iwconfig_status iwconfig_set_frag(iwconfig_handle * handle, const char * wifi,
+						     iwconfig_threshold_mode mode, int value);
+IWCONFIG_C_EXPORT iwconfig_status iwconfig_set_retry(iwconfig_handle * handle, const char * wifi, int value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
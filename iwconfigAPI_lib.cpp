@@ -0,0 +1,1016 @@
+/*****************************************************************************************
+* Title: 	iwconfigAPI library                                                      *
+* Purpose: 	Implementation of the iwconfigAPI class declared in iwconfigAPI.h. It is *
+*		compiled once into libiwconfigapi (static and shared) instead of being   *
+*		inlined into every program that includes the header. Documentation of    *
+*		each function is kept with its declaration in iwconfigAPI.h.             *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include "iwconfigAPI.h"
+#include<algorithm>
+#include<iostream>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<sstream>
+#include<string_view>
+#include<ctype.h>
+#include<functional>
+#include<mutex>
+#include<sys/wait.h>
+
+using namespace std;
+
+/*****************************************************************************************
+* With Unit: a frequency or bit rate as one iwconfig argument, the unit suffix attached  *
+* ("2.412G", "54M"). iwconfig reads a separate unit word as the next request.            *
+*****************************************************************************************/
+static string withUnit(double value, fUnits units){
+    char text[32];
+    snprintf(text, sizeof text, "%.9g", value);
+    string arg(text);
+    switch (units) {
+	case kHz: arg.append("k"); break;
+	case MHz: arg.append("M"); break;
+	case GHz: arg.append("G"); break;
+	default: break; //raw
+    }
+    return arg;
+}
+
+/*****************************************************************************************
+* Metric Value                                                                           *
+*****************************************************************************************/
+iwStatus iwMetricValue(const iwSnapshot & snap, iwMetric metric, double & value){
+    switch (metric) {
+	case metricEssid: value = (double)(hash<string>()(snap.essid.value) >> 12); return snap.essid.status;
+	case metricTxpower: value = snap.txpower.value; return snap.txpower.status;
+	case metricSignal: value = snap.signal.value; return snap.signal.status;
+	case metricFrequency: value = snap.frequency.value; return snap.frequency.status;
+	case metricChannel: value = snap.channel.value; return snap.channel.status;
+	case metricMode: value = snap.mode.value; return snap.mode.status;
+	case metricBitrate: value = snap.bitrate.value; return snap.bitrate.status;
+	case metricRts: value = snap.rts.value; return snap.rts.status;
+	case metricFrag: value = snap.frag.value; return snap.frag.status;
+	case metricRetry: value = snap.retry.value; return snap.retry.status;
+	case metricAccessPoint: value = (double)(hash<string>()(snap.accessPoint.value) >> 12); return snap.accessPoint.status;
+	default: return iwNotFound;
+    }
+}
+
+/*****************************************************************************************
+* Shell Backend                                                                          *
+*****************************************************************************************/
+iwStatus iwShellBackend::run(const string & command, string & data) noexcept {
+    FILE * stream;
+    const int max_buffer = 256;
+    char buffer[max_buffer];
+    size_t len;
+    data.clear();
+    // append 2>&1 to  command this will direct the stdout to the stream
+    string cmd = command;
+    cmd.append(" 2>&1");
+    // execute the command specified by the string cmd.
+    stream = popen(cmd.c_str(), "r");
+    if (!stream) return iwBackendFailure;
+    while ((len = fread(buffer, 1, max_buffer, stream)) > 0) data.append(buffer, len);
+    int rc = pclose(stream); // close the command stream
+    if (rc == -1 || (WIFEXITED(rc) && WEXITSTATUS(rc) == 127)) return iwBackendFailure;
+    return iwOK;
+}
+
+/*****************************************************************************************
+* Command Execution and Parse Helpers                                                    *
+*****************************************************************************************/
+string iwconfigAPI::GetStdoutFromCommand(string cmd) {
+    string data;
+    RunCommand(cmd, data);
+    return data;
+}
+
+iwStatus iwconfigAPI::RunCommand(const string & cmd, string & data) noexcept {
+    return backend->run(cmd, data);
+}
+
+iwStatus iwconfigAPI::RunSetting(const string & cmd) noexcept {
+    string data;
+    iwStatus status = RunCommand(cmd, data);
+    if (status != iwOK) return status;
+    return checkSetting(data);
+}
+
+iwStatus iwconfigAPI::checkSetting(const string & text) noexcept {
+    // iwconfig prints nothing once the setting is applied, but may still print warnings
+    // (wireless extension version mismatch ...), so only its error messages count
+    if (checkDevice(text) != iwOK) return iwNotFound;
+    if (text.find("Error") != string::npos) return iwParseError;   // Error for wireless request, unrecognised request
+    if (text.find("Invalid") != string::npos) return iwParseError; // Invalid argument type, Invalid value
+    if (text.find("unknown command") != string::npos) return iwParseError;
+    return iwOK;
+}
+
+iwStatus iwconfigAPI::checkDevice(const string & text) noexcept {
+    if (text.find("No such device") != string::npos) return iwNotFound;
+    if (text.find("no wireless extensions") != string::npos) return iwNotFound;
+    return iwOK;
+}
+
+iwStatus iwconfigAPI::parseKeyNumber(const string & text, const char * key, size_t skip, double & value) noexcept {
+    size_t found = text.find(key, 1);
+    if (found == string::npos) return iwNotFound;
+    found = found + strlen(key) + skip;
+    if (found >= text.length()) return iwParseError;
+    const char * start = text.c_str() + found;
+    if (strncmp(start, "off", 3) == 0) return iwOff;
+    char * end;
+    double data = strtod(start, &end);
+    if (end == start) return iwParseError;
+    value = data;
+    return iwOK;
+}
+
+iwStatus iwconfigAPI::parseRawNumber(const string & text, double & value) noexcept {
+    const char * start = text.c_str();
+    while (isspace((unsigned char)*start)) start++;
+    if (*start == '\0') return iwNotFound; // iwgetid prints nothing when unassociated
+    char * end;
+    double data = strtod(start, &end);
+    if (end == start) return iwParseError;
+    value = data;
+    return iwOK;
+}
+
+iwStatus iwconfigAPI::parseESSID(const string & text, string & value) noexcept {
+    size_t found = text.find("ESSID:", 1);
+    if (found == string::npos) return iwNotFound;
+    found = found + 6;
+    if (text.compare(found, 7, "off/any") == 0) return iwOff;
+    if (found >= text.length() || text[found] != '"') return iwParseError;
+    size_t secondQuote = text.find('"', found + 1);
+    if (secondQuote == string::npos) return iwParseError;
+    value.assign(text, found + 1, secondQuote - found - 1);
+    return iwOK;
+}
+
+iwStatus iwconfigAPI::parseRetry(const string & text, double & value) noexcept {
+    iwStatus status = parseKeyNumber(text, "Retry short limit:", 0, value);
+    if (status == iwNotFound) status = parseKeyNumber(text, "Retry short  long limit:", 0, value);
+    return status;
+}
+
+iwStatus iwconfigAPI::parseFrequency(const string & text, double & value) noexcept {
+    double data;
+    iwStatus status = parseKeyNumber(text, "Frequency:", 0, data);
+    if (status != iwOK) return status;
+    size_t unit = text.find("Hz", text.find("Frequency:", 1));
+    if (unit != string::npos && unit > 0) {
+	switch (text[unit - 1]) {
+	    case 'G': data *= 1e9; break;
+	    case 'M': data *= 1e6; break;
+	    case 'k': data *= 1e3; break;
+	}
+    }
+    value = data;
+    return iwOK;
+}
+
+int iwconfigAPI::channelFromFrequency(double hz) noexcept {
+    if (hz < 1000) return (int)hz; // already a channel
+    double mhz = hz / 1e6;
+    if (mhz > 2483 && mhz < 2485) return 14;
+    if (mhz >= 2411 && mhz < 2483) return (int)((mhz - 2407) / 5 + 0.5);
+    if (mhz >= 4910 && mhz < 5900) return (int)((mhz - 5000) / 5 + 0.5);
+    return 0;
+}
+
+iwStatus iwconfigAPI::parseMode(const string & text, int & value) noexcept {
+    static const char * names[] = {"Auto", "Ad-Hoc", "Managed", "Master", "Repeater", "Secondary", "Monitor"};
+    size_t found = text.find("Mode:", 1);
+    if (found == string::npos) return iwNotFound;
+    found = found + 5;
+    for (int mode = 0; mode < 7; mode++) {
+	size_t len = strlen(names[mode]);
+	if (text.compare(found, len, names[mode]) == 0) {
+		value = mode;
+		return iwOK;
+	}
+    }
+    return iwParseError;
+}
+
+iwStatus iwconfigAPI::parseAccessPoint(const string & text, string & value) noexcept {
+    size_t found = text.find("Access Point: ", 1);
+    size_t skip = 14;
+    if (found == string::npos) {
+	found = text.find("Cell: ", 1);
+	skip = 6;
+    }
+    if (found == string::npos) return iwNotFound;
+    found = found + skip;
+    if (text.compare(found, 14, "Not-Associated") == 0) return iwOff;
+    if (found + 17 > text.length()) return iwParseError;
+    value.assign(text, found, 17);
+    if (value == "00:00:00:00:00:00") return iwOff;
+    return iwOK;
+}
+
+void iwconfigAPI::parseSnapshot(const string & text, iwSnapshot & snap) noexcept {
+    double data = 0;
+    snap.essid.value = "off/any";
+    snap.essid.status = parseESSID(text, snap.essid.value);
+    snap.txpower.value = -174;
+    snap.txpower.status = parseKeyNumber(text, "Tx-Power=", 0, snap.txpower.value);
+    snap.signal.value = -174;
+    snap.signal.status = parseKeyNumber(text, "Signal level=", 0, snap.signal.value);
+    snap.frequency.value = 0;
+    snap.frequency.status = parseFrequency(text, snap.frequency.value);
+    snap.channel.status = snap.frequency.status;
+    snap.channel.value = channelFromFrequency(snap.frequency.value);
+    snap.mode.value = Managed;
+    snap.mode.status = parseMode(text, snap.mode.value);
+    snap.bitrate.value = 0;
+    snap.bitrate.status = parseKeyNumber(text, "Bit Rate=", 0, snap.bitrate.value);
+    snap.rts.value = 0;
+    snap.rts.status = parseKeyNumber(text, "RTS thr", 1, snap.rts.value);
+    snap.frag.value = 0;
+    snap.frag.status = parseKeyNumber(text, "Fragment thr", 1, snap.frag.value);
+    snap.retry.status = parseRetry(text, data);
+    snap.retry.value = snap.retry.ok() ? (int)data : 0;
+    snap.accessPoint.value = "No Access Point";
+    snap.accessPoint.status = parseAccessPoint(text, snap.accessPoint.value);
+}
+
+iwStatus iwconfigAPI::parseScanCell(const string & text, iwScanCell & cell) noexcept {
+    size_t found = text.find("Address: ");
+    if (found == string::npos || found + 26 > text.length()) return iwParseError;
+    cell.bssid.assign(text, found + 9, 17);
+    cell.essid.clear();
+    iwStatus status = parseESSID(text, cell.essid);
+    if (status == iwParseError) return status;
+    cell.frequency = 0;
+    parseFrequency(text, cell.frequency);
+    double data = 0;
+    if (parseKeyNumber(text, "Channel:", 0, data) == iwOK) cell.channel = (int)data;
+    else cell.channel = channelFromFrequency(cell.frequency);
+    if (cell.frequency < 1000 && cell.channel > 0) { // some drivers print only the channel
+	cell.frequency = cell.channel == 14 ? 2.484e9
+	    : (cell.channel < 14 ? 2407 + 5 * cell.channel : 5000 + 5 * cell.channel) * 1e6;
+    }
+    cell.signal = -174;
+    cell.quality = 0;
+    size_t level = text.find("Signal level=");
+    if (level != string::npos) {
+	// dBm, unless the driver only has a relative level printed as a/b
+	char * end;
+	data = strtod(text.c_str() + level + 13, &end);
+	if (end != text.c_str() + level + 13 && *end != '/') cell.signal = data;
+    }
+    if (parseKeyNumber(text, "Quality=", 0, data) == iwOK) {
+	size_t slash = text.find('/', text.find("Quality="));
+	double scale = slash == string::npos ? 0 : strtod(text.c_str() + slash + 1, NULL);
+	if (scale > 0) cell.quality = min(1.0, max(0.0, data / scale));
+    }
+    return iwOK;
+}
+
+/*****************************************************************************************
+* Interface Locks, Construction and Destruction                                          *
+*****************************************************************************************/
+shared_mutex & iwconfigAPI::interfaceLock(const string & spelled) {
+    // "wlan0 " (as getWIFIList returns it) and "wlan0" are the same adapter
+    size_t end = spelled.find_last_not_of(' ');
+    string_view wifi(spelled.data(), end == string::npos ? 0 : end + 1);
+    size_t slot = hash<string_view>()(wifi) & (lockSlots - 1);
+    ifaceLock * fresh = NULL;
+    for (size_t probe = 0; probe < lockSlots; probe++) {
+	atomic<ifaceLock*> & cell = lockTable[(slot + probe) & (lockSlots - 1)];
+	ifaceLock * entry = cell.load(memory_order_acquire);
+	if (entry == NULL) { // empty slot, try to claim it
+		if (fresh == NULL) {
+			fresh = new ifaceLock();
+			fresh->name = wifi;
+		}
+		if (cell.compare_exchange_strong(entry, fresh, memory_order_acq_rel)) {
+			return fresh->rw;
+		}
+		// lost the race, entry now holds the winner
+	}
+	if (entry->name == wifi) {
+		delete fresh;
+		return entry->rw;
+	}
+    }
+    delete fresh;
+    return lockOverflow;
+}
+
+iwconfigAPI::iwconfigAPI() : backend(make_shared<iwShellBackend>()) {
+    for (size_t i = 0; i < lockSlots; i++) lockTable[i].store(NULL, memory_order_relaxed);
+}
+
+iwconfigAPI::iwconfigAPI(shared_ptr<iwBackend> commandBackend) : backend(commandBackend) {
+    for (size_t i = 0; i < lockSlots; i++) lockTable[i].store(NULL, memory_order_relaxed);
+}
+
+iwconfigAPI::~iwconfigAPI() {
+    for (size_t i = 0; i < lockSlots; i++) delete lockTable[i].load(memory_order_relaxed);
+}
+
+/*****************************************************************************************
+* Getters and Setters                                                                    *
+*****************************************************************************************/
+vector<string> iwconfigAPI::getWIFIList() {
+    string data;
+    int posCR;
+    int posSP;
+    vector<string> data_array;
+    // Execute iwconfig command to find all interfaces. 
+    string iwconfig = GetStdoutFromCommand("iwconfig");
+    string line;    
+    // Break returned string into lines. 
+    while ((posCR = iwconfig.find('\n',1)) < iwconfig.length()) {
+	posCR = iwconfig.find('\n',1);
+	line = iwconfig.substr(0,posCR); // extract current line
+	if (line.length() > 1) { // not a blank line
+		// look for "no wireless extensions." if not found process line. 
+		if(line.find("no wireless extensions.",1) == string::npos){
+			if (line.at(1) != ' ') { // if first character is not a space
+			// then the line contains an interface name.  
+				posSP = line.find(' ',1);// find first space
+			        line = line.substr(1,posSP);// extract interface name
+				data_array.push_back(line);// append name to array.
+				}
+		    	}
+		}
+	iwconfig.erase(0,posCR);// clear out current line. 
+    }
+    return data_array;
+}
+
+int iwconfigAPI::getWIFICount() {
+    int posCR;
+    int cnt = 0;
+    // Execute iwconfig command to find all interfaces. 
+    string iwconfig = GetStdoutFromCommand("iwconfig");
+    string line;    
+    // Break returned string into lines. 
+    while ((posCR = iwconfig.find('\n',1)) < iwconfig.length()) {
+	posCR = iwconfig.find('\n',1);
+	line = iwconfig.substr(0,posCR);// extract current line
+	if (line.length() > 1) {// not a blank line
+		// look for "no wireless extensions." if not found process line. 
+		if(line.find("no wireless extensions.",1) == string::npos){
+			if (line.at(1) != ' ') {// if first character is not a space
+			       // then the line contains an interface name.  
+				cnt += 1;//increment infterface count
+				}
+		    	}
+		}
+	iwconfig.erase(0,posCR);// clear out current line.
+    }
+    return cnt;
+}
+
+string iwconfigAPI::getESSID(string wifi) {
+    shared_lock<shared_mutex> guard(interfaceLock(wifi)); // concurrent readers
+    size_t found;
+    size_t firstQuote;
+    size_t secondQuote;
+    size_t ESSIDLen;
+    string data = "off/any";
+    string cmd = "iwconfig ";
+    cmd.append(wifi);
+    string iwconfig = GetStdoutFromCommand(cmd);
+    found  = iwconfig.find("ESSID:",1);
+    if (found != string::npos){ // found keyword
+ 	   found = found + 6;             
+	   size_t firstQuote = iwconfig.find("\"",found);
+		    if (firstQuote != string::npos){ // found quote
+			   firstQuote = firstQuote + 1;
+			   secondQuote = iwconfig.find("\"",firstQuote);
+			   ESSIDLen = secondQuote - firstQuote; 
+			}
+		    else { // off/any
+			   firstQuote = found;
+ 			   ESSIDLen = 7; 
+			}
+	   data = iwconfig.substr(firstQuote,ESSIDLen);
+    }
+    return data;
+}
+
+iwStatus iwconfigAPI::setESSID(string wifi, string value ) {
+    unique_lock<shared_mutex> guard(interfaceLock(wifi)); // fence out readers
+    string cmd = "iwconfig ";
+    cmd.append(wifi);
+    cmd.append(" essid ");
+    cmd.append(value); //value can be a name or the following keyword: any, on, off
+    return RunSetting(cmd);
+}
+
+double iwconfigAPI::getTX_Power(string wifi) {
+    shared_lock<shared_mutex> guard(interfaceLock(wifi)); // concurrent readers
+    size_t found;
+    double data = -174.0;
+    string cmd = "iwconfig ";
+    cmd.append(wifi);
+    string iwconfig = GetStdoutFromCommand(cmd);
+    found  = iwconfig.find("Tx-Power=",1);
+    if (found != string::npos){ // found txpower keyword
+ 	   found = found + 9;             
+	   string sdata =iwconfig.substr(found,3);
+	  if (sdata.compare("off") != 0){ // did not find off
+ 	   	data = stof(sdata);
+		}
+    }
+    return data;
+}
+
+iwStatus iwconfigAPI::setTXPower(string wifi, txMode mode, int value ) {
+    unique_lock<shared_mutex> guard(interfaceLock(wifi)); // fence out readers
+    string cmd = "iwconfig ";
+    cmd.append(wifi);
+    cmd.append(" txpower ");
+	 switch (mode) { 
+	    case automatic:
+		cmd.append("auto"); 
+		break; 
+	    case off: 
+		cmd.append("off"); 
+		break; 
+	    case on: 
+		cmd.append("on"); 
+		break; 
+	    case dBm: 
+		cmd.append(to_string(value));
+		break; 
+	    case mW: 
+		cmd.append(to_string(value));
+		cmd.append("mW"); 
+		break; 
+	    default: 
+		cmd.append(to_string(value));
+	    } 
+    return RunSetting(cmd);
+}
+
+double iwconfigAPI::getSignalLevel(string wifi) {
+    shared_lock<shared_mutex> guard(interfaceLock(wifi)); // concurrent readers
+    size_t found;
+    double data = -174;
+    string cmd = "iwconfig ";
+    cmd.append(wifi);
+    string iwconfig = GetStdoutFromCommand(cmd);
+    found  = iwconfig.find("Signal level=",1);
+    if (found != string::npos){ // found keyword
+ 	   found = found + 13;
+	   string sdata =iwconfig.substr(found,3);
+	  if (sdata.compare("off") != 0){ // did not find off
+ 	   	data = stof(sdata);
+		}
+    }
+    return data;
+}
+
+iwStatus iwconfigAPI::setSensitivity(string wifi, int value ) {
+    unique_lock<shared_mutex> guard(interfaceLock(wifi)); // fence out readers
+    string cmd = "iwconfig ";
+    cmd.append(wifi);
+    cmd.append(" sens ");
+    cmd.append(to_string(value));
+    return RunSetting(cmd);
+}
+
+double iwconfigAPI::getFrequency(string wifi) {
+    shared_lock<shared_mutex> guard(interfaceLock(wifi)); // concurrent readers
+    double data = 0;
+    string cmd = "iwgetid ";
+    cmd.append(wifi);
+    cmd.append(" --raw --freq");
+    string sfreq = GetStdoutFromCommand(cmd);
+    if (sfreq.length() > 0){ // frequency returned
+ 	   	data = stof(sfreq);
+    }
+    return data;
+}
+
+iwStatus iwconfigAPI::setFrequency(string wifi, double value, fUnits units) {
+    unique_lock<shared_mutex> guard(interfaceLock(wifi)); // fence out readers
+	string cmd = "iwconfig ";
+	cmd.append(wifi);
+	cmd.append(" freq ");
+	cmd.append(withUnit(value, units));
+	return RunSetting(cmd);
+}
+
+int iwconfigAPI::getChannel(string wifi) {
+    shared_lock<shared_mutex> guard(interfaceLock(wifi)); // concurrent readers
+    int data = 0;
+    string cmd = "iwgetid ";
+    cmd.append(wifi);
+    cmd.append(" --raw --channel");
+    string schan = GetStdoutFromCommand(cmd);
+    if (schan.length() > 0){ // channel returned
+ 	   	data = stoi(schan);
+    }
+    return data;
+}
+
+iwStatus iwconfigAPI::setChannel(string wifi, int value) {
+    unique_lock<shared_mutex> guard(interfaceLock(wifi)); // fence out readers
+	string cmd = "iwconfig ";
+	cmd.append(wifi);
+	cmd.append(" channel "); 
+	if ( value > 0){ cmd.append(to_string(value));}
+	else {	cmd.append("auto");}
+	return RunSetting(cmd);
+}
+
+int iwconfigAPI::getMode(string wifi) {
+    shared_lock<shared_mutex> guard(interfaceLock(wifi)); // concurrent readers
+    int data = Managed;
+    string cmd = "iwgetid ";
+    cmd.append(wifi);
+    cmd.append(" --raw --mode");
+
+    string sMode = GetStdoutFromCommand(cmd);
+    if (sMode.length() > 0){ // Mode returned
+ 	   	data = stoi(sMode);
+    }
+    return data;
+}
+
+iwStatus iwconfigAPI::setMode(string wifi, mMode mode) {
+    unique_lock<shared_mutex> guard(interfaceLock(wifi)); // fence out readers
+    string cmd = "iwconfig ";
+    cmd.append(wifi);
+    cmd.append(" mode ");
+	 switch (mode) { 
+	    case AdHoc:
+		cmd.append("Ad-Hoc");
+		break; 
+	    case Managed: 
+		cmd.append("Managed");
+		break; 
+	    case Master: 
+		cmd.append("Master");
+		break; 
+	    case Repeater: 
+		cmd.append("Repeater");
+		break; 
+	    case Secondary: 
+		cmd.append("Secondary");
+		break; 
+	    case Monitor: 
+		cmd.append("Monitor");
+		break; 
+	    case Automatic: 
+		cmd.append("auto");
+		break; 
+	    default: //Automatic
+		cmd.append("auto");
+	    } 
+    return RunSetting(cmd);
+}
+
+string iwconfigAPI::getAccessPoint(string wifi) {
+    shared_lock<shared_mutex> guard(interfaceLock(wifi)); // concurrent readers
+    string sap = "No Access Point";
+    string tsap;
+    string cmd = "iwgetid ";
+    cmd.append(wifi);
+    cmd.append(" --raw --ap");
+    tsap = GetStdoutFromCommand(cmd);
+    if (tsap.length() > 0){ // access point returned
+ 	   	sap = tsap;
+    }
+    return sap;
+}
+
+iwStatus iwconfigAPI::setAccessPoint(string wifi, string value ) {
+    unique_lock<shared_mutex> guard(interfaceLock(wifi)); // fence out readers
+    string cmd = "iwconfig ";
+    cmd.append(wifi);
+    cmd.append(" ap ");
+    cmd.append(value);  
+    return RunSetting(cmd);
+}
+
+double iwconfigAPI::getBitRate(string wifi) {
+    shared_lock<shared_mutex> guard(interfaceLock(wifi)); // concurrent readers
+    size_t found;
+    double data = 0;
+    string cmd = "iwconfig ";
+    cmd.append(wifi);
+    string iwconfig = GetStdoutFromCommand(cmd);
+    found  = iwconfig.find("Bit Rate=",1);
+    if (found != string::npos){ // found keyword
+ 	   found = found + 9;
+           size_t spfound  = iwconfig.find("Mb/s",found)-found;
+	   string sdata =iwconfig.substr(found,spfound);
+     	   	   data = stof(sdata);
+    }
+    return data;
+}
+
+iwStatus iwconfigAPI::setBitRate(string wifi, double value, fUnits units) {
+    unique_lock<shared_mutex> guard(interfaceLock(wifi)); // fence out readers
+	string cmd = "iwconfig ";
+	cmd.append(wifi);
+	cmd.append(" rate ");
+	cmd.append(withUnit(value, units));
+	return RunSetting(cmd);
+}
+
+double iwconfigAPI::getRTS(string wifi) {
+    shared_lock<shared_mutex> guard(interfaceLock(wifi)); // concurrent readers
+    size_t found;
+    double data = 0;
+    string cmd = "iwconfig ";
+    cmd.append(wifi);
+    string iwconfig = GetStdoutFromCommand(cmd);
+    found  = iwconfig.find("RTS thr",1);
+    if (found != string::npos){ // found RTS thr keyword
+ 	   found = found + 8;             
+           string sdata =iwconfig.substr(found,3);
+	  if (sdata.compare("off") != 0){ // did not find off
+		size_t spfound  = iwconfig.find("B",found)-found;
+		sdata =iwconfig.substr(found,spfound);
+ 	   	data = stof(sdata);
+		}
+    }
+    return data;
+}
+
+iwStatus iwconfigAPI::setRTS(string wifi, RTSmode mode, int value ) {
+    unique_lock<shared_mutex> guard(interfaceLock(wifi)); // fence out readers
+    string cmd = "iwconfig ";
+    cmd.append(wifi);
+    cmd.append(" rts ");
+	 switch (mode) { 
+	    case rtsauto:
+		cmd.append("auto"); 
+		break; 
+	    case rtsoff: 
+		cmd.append("off"); 
+		break; 
+	    case rtsfixed: 
+		cmd.append("fixed"); 
+		break; 
+	    case rtsbyte: 
+		cmd.append(to_string(value));
+		break; 
+	    default: //byte number
+		cmd.append(to_string(value));
+	    } 
+    return RunSetting(cmd);
+}
+
+double iwconfigAPI::getFrag(string wifi) {
+    shared_lock<shared_mutex> guard(interfaceLock(wifi)); // concurrent readers
+    size_t found;
+    double data = 0;
+    string cmd = "iwconfig ";
+    cmd.append(wifi);
+    string iwconfig = GetStdoutFromCommand(cmd);
+    found  = iwconfig.find("Fragment thr",1);
+    if (found != string::npos){ // found RTS thr keyword
+ 	   found = found + 13;             
+           string sdata =iwconfig.substr(found,3);
+	  if (sdata.compare("off") != 0){ // did not find off
+		size_t spfound  = iwconfig.find("B",found)-found;
+		sdata =iwconfig.substr(found,spfound);
+ 	   	data = stof(sdata);
+		}
+    }
+    return data;
+}
+
+iwStatus iwconfigAPI::setFrag(string wifi, RTSmode mode, int value ) {
+    unique_lock<shared_mutex> guard(interfaceLock(wifi)); // fence out readers
+    string cmd = "iwconfig ";
+    cmd.append(wifi);
+    cmd.append(" frag ");
+	 switch (mode) { 
+	    case rtsauto:
+		cmd.append("auto"); 
+		break; 
+	    case rtsoff: 
+		cmd.append("off"); 
+		break; 
+	    case rtsfixed: 
+		cmd.append("fixed"); 
+		break; 
+	    case rtsbyte: 
+		cmd.append(to_string(value));
+		break; 
+	    default: //byte number
+		cmd.append(to_string(value));
+	    } 
+    return RunSetting(cmd);
+}
+
+int iwconfigAPI::getRetry(string wifi) {
+    shared_lock<shared_mutex> guard(interfaceLock(wifi)); // concurrent readers
+    size_t found;
+    int data = 0;
+    string cmd = "iwconfig ";
+    cmd.append(wifi);
+    string iwconfig = GetStdoutFromCommand(cmd);
+    found  = iwconfig.find("Retry short limit:",1);
+    if (found != string::npos){ // found Retry keyword
+ 	   found = found + 18;             
+           string sdata =iwconfig.substr(found,3);
+ 	   data = stoi(sdata);
+         }
+    else {
+	    found  = iwconfig.find("Retry short  long limit:",1);
+	    if (found != string::npos){ // found Retry keyword
+	 	   found = found + 24;             
+		   string sdata =iwconfig.substr(found,3);
+	 	   data = stoi(sdata);
+		 }
+         }
+    return data;
+}
+
+iwStatus iwconfigAPI::setRetry(string wifi, int value ) {
+    unique_lock<shared_mutex> guard(interfaceLock(wifi)); // fence out readers
+    string cmd = "iwconfig ";
+    cmd.append(wifi);
+    cmd.append(" retry ");
+    cmd.append(to_string(value));  
+    return RunSetting(cmd);
+}
+
+/*****************************************************************************************
+* Exception Free Getters and Snapshots                                                   *
+*****************************************************************************************/
+iwResult<string> iwconfigAPI::tryGetESSID(const string & wifi) noexcept {
+    iwResult<string> result = {iwOK, "off/any"};
+    string iwconfig;
+    if (!iwconfigQuery(wifi, iwconfig, result.status)) return result;
+    result.status = parseESSID(iwconfig, result.value);
+    return result;
+}
+
+iwResult<double> iwconfigAPI::tryGetTX_Power(const string & wifi) noexcept {
+    return iwconfigNumber(wifi, "Tx-Power=", 0, -174.0);
+}
+
+iwResult<double> iwconfigAPI::tryGetSignalLevel(const string & wifi) noexcept {
+    return iwconfigNumber(wifi, "Signal level=", 0, -174.0);
+}
+
+iwResult<double> iwconfigAPI::tryGetBitRate(const string & wifi) noexcept {
+    return iwconfigNumber(wifi, "Bit Rate=", 0, 0);
+}
+
+iwResult<double> iwconfigAPI::tryGetRTS(const string & wifi) noexcept {
+    return iwconfigNumber(wifi, "RTS thr", 1, 0);
+}
+
+iwResult<double> iwconfigAPI::tryGetFrag(const string & wifi) noexcept {
+    return iwconfigNumber(wifi, "Fragment thr", 1, 0);
+}
+
+iwResult<int> iwconfigAPI::tryGetRetry(const string & wifi) noexcept {
+    iwResult<int> result = {iwOK, 0};
+    string iwconfig;
+    double data = 0;
+    if (!iwconfigQuery(wifi, iwconfig, result.status)) return result;
+    result.status = parseRetry(iwconfig, data);
+    if (result.ok()) result.value = (int)data;
+    return result;
+}
+
+iwResult<double> iwconfigAPI::tryGetFrequency(const string & wifi) noexcept {
+    return iwgetidNumber(wifi, " --raw --freq", 0);
+}
+
+iwResult<int> iwconfigAPI::tryGetChannel(const string & wifi) noexcept {
+    iwResult<double> data = iwgetidNumber(wifi, " --raw --channel", 0);
+    iwResult<int> result = {data.status, (int)data.value};
+    return result;
+}
+
+iwResult<int> iwconfigAPI::tryGetMode(const string & wifi) noexcept {
+    iwResult<double> data = iwgetidNumber(wifi, " --raw --mode", Managed);
+    iwResult<int> result = {data.status, (int)data.value};
+    return result;
+}
+
+iwResult<string> iwconfigAPI::tryGetAccessPoint(const string & wifi) noexcept {
+    iwResult<string> result = {iwOK, "No Access Point"};
+    string tsap;
+    shared_lock<shared_mutex> guard(interfaceLock(wifi)); // concurrent readers
+    result.status = RunCommand("iwgetid " + wifi + " --raw --ap", tsap);
+    if (!result.ok()) return result;
+    size_t end = tsap.find_last_not_of(" \t\r\n");
+    if (end == string::npos) { // iwgetid printed nothing
+	result.status = iwNotFound;
+	return result;
+    }
+    result.value.assign(tsap, 0, end + 1);
+    if (result.value == "00:00:00:00:00:00") result.status = iwOff; // not associated
+    return result;
+}
+
+iwStatus iwconfigAPI::tryGetSnapshot(const string & wifi, iwSnapshot & snap) noexcept {
+    string iwconfig;
+    iwStatus status;
+    if (!iwconfigQuery(wifi, iwconfig, status)) return status;
+    size_t end = wifi.find_last_not_of(' ');
+    snap.name.assign(wifi, 0, end == string::npos ? 0 : end + 1);
+    parseSnapshot(iwconfig, snap);
+    return iwOK;
+}
+
+iwStatus iwconfigAPI::tryGetSnapshots(vector<iwSnapshot> & snaps) noexcept {
+    uint64_t locked[lockSlots / 64] = {0};
+    size_t count = 0;
+    string iwconfig;
+    lockAllShared(locked);
+    iwStatus status = RunCommand("iwconfig", iwconfig);
+    unlockAllShared(locked);
+    if (status != iwOK) {
+	snaps.clear();
+	return status;
+    }
+    try {
+	string block;
+	size_t next, nameEnd;
+	for (size_t start = 0; start < iwconfig.length(); start = next) {
+		if (!nextAdapter(iwconfig, start, next, nameEnd)) continue;
+		if (count == snaps.size()) snaps.emplace_back();
+		iwSnapshot & snap = snaps[count++];
+		snap.name.assign(iwconfig, start, nameEnd - start);
+		block.assign(iwconfig, start, next - start);
+		parseSnapshot(block, snap);
+	}
+	snaps.resize(count);
+    }
+    catch (...) { // out of memory while growing the snapshots
+	snaps.clear();
+	return iwBackendFailure;
+    }
+    return iwOK;
+}
+
+iwStatus iwconfigAPI::tryGetSnapshots(iwSnapshotArena & arena) noexcept {
+    uint64_t locked[lockSlots / 64] = {0};
+    arena.reset();
+    lockAllShared(locked);
+    iwStatus status = RunCommand("iwconfig", arena.text);
+    unlockAllShared(locked);
+    if (status != iwOK) return status;
+    const string & iwconfig = arena.text;
+    size_t next, nameEnd;
+    try {
+	for (size_t start = 0; start < iwconfig.length(); start = next) {
+		if (!nextAdapter(iwconfig, start, next, nameEnd)) continue;
+		arena.scratch.name.assign(iwconfig, start, nameEnd - start);
+		arena.block.assign(iwconfig, start, next - start);
+		parseSnapshot(arena.block, arena.scratch);
+		arena.append(arena.scratch);
+	}
+    }
+    catch (...) { // out of memory while growing the arena
+	arena.reset();
+	return iwBackendFailure;
+    }
+    return iwOK;
+}
+
+iwStatus iwconfigAPI::tryScan(const string & wifi, vector<iwScanCell> & cells) noexcept {
+    size_t count = 0;
+    string iwlist;
+    iwStatus status;
+    {
+    shared_lock<shared_mutex> guard(interfaceLock(wifi)); // a scan changes no setting
+    status = RunCommand("iwlist " + wifi + " scan", iwlist);
+    }
+    if (status == iwOK) status = checkDevice(iwlist);
+    if (status == iwOK && iwlist.find("doesn't support scanning") != string::npos) status = iwNotFound;
+    if (status == iwOK && iwlist.find("Network is down") != string::npos) status = iwOff;
+    if (status == iwOK && iwlist.find("Scan completed") == string::npos
+	&& iwlist.find("No scan results") == string::npos) status = iwParseError;
+    try {
+	// a cell runs from its "Cell NN - Address: " line to the next one, searched by the
+	// address so that an ESSID holding "Cell " cannot split it
+	string block;
+	size_t address = status == iwOK ? iwlist.find(" - Address: ") : string::npos;
+	size_t start = address == string::npos ? address : iwlist.rfind("Cell ", address);
+	while (start != string::npos) {
+		address = iwlist.find(" - Address: ", address + 12);
+		size_t next = address == string::npos ? address : iwlist.rfind("Cell ", address);
+		block.assign(iwlist, start, next == string::npos ? string::npos : next - start);
+		if (count == cells.size()) cells.emplace_back();
+		if (parseScanCell(block, cells[count]) == iwOK) count++;
+		start = next;
+	}
+    }
+    catch (...) { // out of memory while growing the cells
+	status = iwBackendFailure;
+	count = 0;
+    }
+    cells.resize(count);
+    return status;
+}
+
+/*****************************************************************************************
+* Snapshot Arena                                                                         *
+*****************************************************************************************/
+size_t iwSnapshotArena::capacityBytes() const noexcept {
+    size_t bytes = pool.capacity() + text.capacity() + block.capacity()
+	+ (nameOffset.capacity() + essidOffset.capacity() + apOffset.capacity()) * sizeof(uint32_t);
+    for (int m = 0; m < metricCount; m++) bytes += values[m].capacity() * sizeof(double) + status[m].capacity();
+    return bytes;
+}
+
+void iwSnapshotArena::reset() noexcept {
+    generationCount++;
+    pool.clear();
+    nameOffset.clear();
+    essidOffset.clear();
+    apOffset.clear();
+    for (int m = 0; m < metricCount; m++) {
+	values[m].clear();
+	status[m].clear();
+    }
+}
+
+uint32_t iwSnapshotArena::intern(const string & value) {
+    uint32_t offset = (uint32_t)pool.size();
+    pool.insert(pool.end(), value.c_str(), value.c_str() + value.length() + 1);
+    return offset;
+}
+
+void iwSnapshotArena::append(const iwSnapshot & snap) {
+    nameOffset.push_back(intern(snap.name));
+    essidOffset.push_back(intern(snap.essid.value));
+    apOffset.push_back(intern(snap.accessPoint.value));
+    for (int m = 0; m < metricCount; m++) {
+	double value = 0;
+	status[m].push_back((uint8_t)iwMetricValue(snap, (iwMetric)m, value));
+	values[m].push_back(value);
+    }
+}
+
+/*****************************************************************************************
+* Private Query Helpers                                                                  *
+*****************************************************************************************/
+void iwconfigAPI::lockAllShared(uint64_t * locked) {
+    for (size_t i = 0; i < lockSlots; i++) {
+	ifaceLock * entry = lockTable[i].load(memory_order_acquire);
+	if (!entry) continue;
+	entry->rw.lock_shared();
+	locked[i / 64] |= 1ULL << (i % 64);
+    }
+    lockOverflow.lock_shared();
+}
+
+void iwconfigAPI::unlockAllShared(const uint64_t * locked) {
+    lockOverflow.unlock_shared();
+    for (size_t i = 0; i < lockSlots; i++) {
+	if (locked[i / 64] & (1ULL << (i % 64))) lockTable[i].load(memory_order_acquire)->rw.unlock_shared();
+    }
+}
+
+bool iwconfigAPI::nextAdapter(const string & text, size_t start, size_t & next, size_t & nameEnd) noexcept {
+    next = start;
+    // a block runs until the next line that starts with a name
+    do {
+	next = text.find('\n', next);
+	next = next == string::npos ? text.length() : next + 1;
+    } while (next < text.length() && (text[next] == ' ' || text[next] == '\n'));
+    nameEnd = text.find_first_of(" \t\n", start);
+    return nameEnd > start && nameEnd < next // skip blank lines
+	&& string_view(text.data() + start, next - start).find("no wireless extensions.") == string_view::npos;
+}
+
+bool iwconfigAPI::iwconfigQuery(const string & wifi, string & iwconfig, iwStatus & status) noexcept {
+    shared_lock<shared_mutex> guard(interfaceLock(wifi)); // concurrent readers
+    status = RunCommand("iwconfig " + wifi, iwconfig);
+    if (status == iwOK) status = checkDevice(iwconfig);
+    return status == iwOK;
+}
+
+iwResult<double> iwconfigAPI::iwconfigNumber(const string & wifi, const char * key, size_t skip, double def) noexcept {
+    iwResult<double> result = {iwOK, def};
+    string iwconfig;
+    if (!iwconfigQuery(wifi, iwconfig, result.status)) return result;
+    result.status = parseKeyNumber(iwconfig, key, skip, result.value);
+    return result;
+}
+
+iwResult<double> iwconfigAPI::iwgetidNumber(const string & wifi, const char * args, double def) noexcept {
+    iwResult<double> result = {iwOK, def};
+    string data;
+    shared_lock<shared_mutex> guard(interfaceLock(wifi)); // concurrent readers
+    result.status = RunCommand("iwgetid " + wifi + args, data);
+    if (result.ok()) result.status = parseRawNumber(data, result.value);
+    return result;
+}
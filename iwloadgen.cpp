@@ -0,0 +1,177 @@
+/*****************************************************************************************
+* Title: 	iwloadgen                                                                *
+* Purpose: 	Load generator for iwconfigAPI on the simulated radio backend. For every *
+*		interface count it measures getWIFIList and then drives random tryGet    *
+*		and setter calls on random interfaces from several threads, reporting    *
+*		operations per second and tail latency as the number of interfaces       *
+*		grows. With setters in the mix, reads and writes of the same interface   *
+*		contend on its lock, which makes it a concurrency load as well.          *
+*                                                                                        *
+*		usage: iwloadgen [--radios 1,10,100,1000] [--threads N] [--seconds S]    *
+*		                 [--sets p] [--latency us] [--jitter us] [--failure p]   *
+*		                 [--garble p] [--seed n]                                 *
+*		    --sets p   fraction of the calls that are setters (default 0.1)      *
+*		errors counts the gets and sets that did not return iwOK (iwOff is a     *
+*		valid answer of a get), as a share of all calls.                         *
+*****************************************************************************************/
+#include "iwSim.h"
+#include<algorithm>
+#include<iostream>
+#include<sstream>
+
+using namespace std;
+
+static double percentile(vector<double> & sorted, double p){
+   if (sorted.empty()) return 0;
+   return sorted[(size_t)(p * (sorted.size() - 1) + 0.5)];
+}
+
+// One random tryGet call, returns its status.
+static iwStatus randomGet(iwconfigAPI & wifiAPI, const string & wifi, int op){
+   switch (op) {
+      case 0: return wifiAPI.tryGetESSID(wifi).status;
+      case 1: return wifiAPI.tryGetTX_Power(wifi).status;
+      case 2: return wifiAPI.tryGetSignalLevel(wifi).status;
+      case 3: return wifiAPI.tryGetBitRate(wifi).status;
+      case 4: return wifiAPI.tryGetRTS(wifi).status;
+      case 5: return wifiAPI.tryGetFrag(wifi).status;
+      case 6: return wifiAPI.tryGetRetry(wifi).status;
+      case 7: return wifiAPI.tryGetFrequency(wifi).status;
+      case 8: return wifiAPI.tryGetChannel(wifi).status;
+      case 9: return wifiAPI.tryGetMode(wifi).status;
+      default: return wifiAPI.tryGetAccessPoint(wifi).status;
+   }
+}
+
+// One random setter.
+static iwStatus randomSet(iwconfigAPI & wifiAPI, const string & wifi, int op, mt19937 & rng){
+   uniform_int_distribution<int> pick(0, 9);
+   int value = pick(rng);
+   switch (op) {
+      case 0: return wifiAPI.setTXPower(wifi, dBm, 10 + value);
+      case 1: return wifiAPI.setChannel(wifi, 1 + value);
+      case 2: return wifiAPI.setFrequency(wifi, 2.412 + 0.005 * value, GHz);
+      case 3: return wifiAPI.setBitRate(wifi, value < 5 ? 24 : 54, MHz);
+      case 4: return wifiAPI.setRTS(wifi, rtsbyte, 256 * (value + 1));
+      default: return wifiAPI.setRetry(wifi, 4 + value);
+   }
+}
+
+static void usage(){
+   cerr << "usage: iwloadgen [--radios 1,10,100,1000] [--threads N] [--seconds S]\n"
+	   "                 [--sets p] [--latency us] [--jitter us] [--failure p]\n"
+	   "                 [--garble p] [--seed n]\n";
+}
+
+int main(int argc, char ** argv){
+   vector<int> counts = {1, 10, 100, 1000};
+   int threads = 4;
+   double seconds = 1;
+   double sets = 0.1;
+   iwSimConfig config;
+   for (int i = 1; i + 1 < argc; i += 2) {
+      string arg = argv[i];
+      if (arg == "--radios") {
+	 counts.clear();
+	 istringstream list(argv[i + 1]);
+	 string item;
+	 while (getline(list, item, ',')) counts.push_back(atoi(item.c_str()));
+      }
+      else if (arg == "--threads") threads = atoi(argv[i + 1]);
+      else if (arg == "--sets") sets = atof(argv[i + 1]);
+      else if (arg == "--seed") config.seed = strtoul(argv[i + 1], NULL, 0);
+      else if (arg == "--seconds") seconds = atof(argv[i + 1]);
+      else if (arg == "--latency") config.latency_us = atof(argv[i + 1]);
+      else if (arg == "--jitter") config.jitter_us = atof(argv[i + 1]);
+      else if (arg == "--failure") config.failure_rate = atof(argv[i + 1]);
+      else if (arg == "--garble") config.garble_rate = atof(argv[i + 1]);
+      else {
+	 cerr << "unknown option " << arg << "\n";
+	 usage();
+	 return 2;
+      }
+   }
+   bool radiosOk = !counts.empty();
+   for (size_t c = 0; c < counts.size(); c++) radiosOk = radiosOk && counts[c] >= 1;
+   if (!radiosOk) cerr << "--radios needs a list of counts of at least 1\n";
+   if (threads < 1 || seconds <= 0 || sets < 0 || sets > 1 || !radiosOk) {
+      usage();
+      return 2;
+   }
+
+   printf("%8s %8s %10s %10s %12s %10s %10s %10s %10s %8s %10s %10s %10s\n", "radios", "lists", "list p50us",
+	  "list p99us", "get ops/s", "get p50us", "get p99us", "p99.9us", "max us", "errors", "set ops/s",
+	  "set p50us", "set p99us");
+   for (size_t c = 0; c < counts.size(); c++) {
+      config.radios = counts[c];
+      shared_ptr<iwSimBackend> backend = make_shared<iwSimBackend>(config);
+      iwconfigAPI wifiAPI(backend);
+
+      // getWIFIList: repeat for a fifth of the budget (at least three calls).
+      vector<double> listLatency;
+      vector<string> wifi;
+      chrono::steady_clock::time_point listEnd = chrono::steady_clock::now()
+	 + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds / 5));
+      while (listLatency.size() < 3 || chrono::steady_clock::now() < listEnd) {
+	 chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+	 wifi = wifiAPI.getWIFIList();
+	 listLatency.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count());
+      }
+      sort(listLatency.begin(), listLatency.end());
+      if (wifi.empty()) { // every list call failed, fall back to the known names
+	 for (int i = 0; i < backend->radioCount(); i++) wifi.push_back(backend->radioName(i));
+      }
+
+      // Every thread picks a random interface and a random tryGet, or a random setter.
+      vector<vector<double>> latency(threads), setLatency(threads);
+      vector<long> errors(threads, 0);
+      vector<thread> workers;
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      chrono::steady_clock::time_point end = start
+	 + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+      for (int t = 0; t < threads; t++) {
+	 workers.emplace_back([&, t]() {
+	    mt19937 rng(config.seed * 7919 + t);
+	    uniform_int_distribution<size_t> pickRadio(0, wifi.size() - 1);
+	    uniform_int_distribution<int> pickOp(0, 10);
+	    uniform_int_distribution<int> pickSet(0, 5);
+	    bernoulli_distribution isSet(sets);
+	    while (chrono::steady_clock::now() < end) {
+	       const string & name = wifi[pickRadio(rng)];
+	       if (isSet(rng)) {
+		  int op = pickSet(rng);
+		  chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+		  iwStatus status = randomSet(wifiAPI, name, op, rng);
+		  setLatency[t].push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count());
+		  if (status != iwOK) errors[t]++;
+		  continue;
+	       }
+	       int op = pickOp(rng);
+	       chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+	       iwStatus status = randomGet(wifiAPI, name, op);
+	       latency[t].push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count());
+	       if (status != iwOK && status != iwOff) errors[t]++;
+	    }
+	 });
+      }
+      for (size_t t = 0; t < workers.size(); t++) workers[t].join();
+      double wall = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+      vector<double> all, allSets;
+      long errorCount = 0;
+      for (int t = 0; t < threads; t++) {
+	 all.insert(all.end(), latency[t].begin(), latency[t].end());
+	 allSets.insert(allSets.end(), setLatency[t].begin(), setLatency[t].end());
+	 errorCount += errors[t];
+      }
+      sort(all.begin(), all.end());
+      sort(allSets.begin(), allSets.end());
+      printf("%8d %8zu %10.1f %10.1f %12.0f %10.1f %10.1f %10.1f %10.1f %7.2f%% %10.0f %10.1f %10.1f\n", counts[c],
+	     listLatency.size(), percentile(listLatency, 0.5), percentile(listLatency, 0.99), all.size() / wall,
+	     percentile(all, 0.5), percentile(all, 0.99), percentile(all, 0.999),
+	     all.empty() ? 0 : all.back(), all.empty() && allSets.empty() ? 0 : 100.0 * errorCount / (all.size() + allSets.size()),
+	     allSets.size() / wall, percentile(allSets, 0.5), percentile(allSets, 0.99));
+      fflush(stdout);
+   }
+   return 0;
+}
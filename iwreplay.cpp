@@ -0,0 +1,179 @@
+/*****************************************************************************************
+* Title: 	iwreplay                                                                 *
+* Purpose: 	Regression harness for iwconfigAPI. Replays a trace written by the       *
+*		recording backend against the API of this build and reports throughput   *
+*		and latency per command class next to the values that were recorded.     *
+*		Throughput is commands per second of busy time (the sum of the command   *
+*		latencies) for both the recording and the replay, so idle gaps between   *
+*		commands do not enter the comparison. With --timed every replayed        *
+*		command also waits out its recorded latency in the backend, so the       *
+*		replayed numbers include the recorded ones; compare fast runs.           *
+*		Every recorded command is turned back into the API call that issues it   *
+*		(iwconfig <if> rotates through the iwconfig based tryGet functions) so   *
+*		the parsing code of this build is what gets measured.                    *
+*                                                                                        *
+*		usage: iwreplay <trace> [--timed] [--passes N]                           *
+*		    --timed     keep the recorded inter-arrival times and latencies      *
+*		    --passes N  replay the trace N times (default 1)                     *
+*****************************************************************************************/
+#include "iwTrace.h"
+#include<algorithm>
+#include<map>
+#include<iostream>
+#include<sstream>
+
+using namespace std;
+
+struct latencies {
+   vector<double> recorded; // microseconds
+   vector<double> replayed; // microseconds
+};
+
+// Command class: program, interface placeholder and the option that selects the field.
+static string commandClass(const string & cmd){
+   istringstream words(cmd);
+   vector<string> tokens;
+   string token;
+   while (words >> token) tokens.push_back(token);
+   if (tokens.empty()) return "<empty>";
+   string cls = tokens[0];
+   if (tokens.size() > 1) cls.append(" <if>");
+   for (size_t i = 2; i < tokens.size(); i++) {
+      if (tokens[0] == "iwconfig" && i > 2) break; // drop set values
+      cls.append(" ").append(tokens[i]);
+   }
+   return cls;
+}
+
+static double percentile(vector<double> values, double p){
+   if (values.empty()) return 0;
+   sort(values.begin(), values.end());
+   size_t index = (size_t)(p * (values.size() - 1) + 0.5);
+   return values[index];
+}
+
+static double mean(const vector<double> & values){
+   double sum = 0;
+   for (size_t i = 0; i < values.size(); i++) sum += values[i];
+   return values.empty() ? 0 : sum / values.size();
+}
+
+int main(int argc, char ** argv){
+   string path;
+   replayMode mode = replayFast;
+   int passes = 1;
+   for (int i = 1; i < argc; i++) {
+      string arg = argv[i];
+      if (arg == "--timed") mode = replayTimed;
+      else if (arg == "--passes" && i + 1 < argc) passes = atoi(argv[++i]);
+      else path = arg;
+   }
+   if (path.empty() || passes < 1) {
+      cerr << "usage: iwreplay <trace> [--timed] [--passes N]\n";
+      return 2;
+   }
+
+   shared_ptr<iwReplayBackend> backend = make_shared<iwReplayBackend>(path, mode);
+   const vector<iwTraceRecord> & trace = backend->records();
+   if (!backend->good()) cerr << "warning: " << path << " is truncated or corrupt, using " << trace.size() << " records\n";
+   if (trace.empty()) {
+      cerr << "no records in " << path << "\n";
+      return 1;
+   }
+   iwconfigAPI wifiAPI(backend);
+
+   map<string, latencies> classes;
+   double recordedBusy = 0;
+   for (size_t i = 0; i < trace.size(); i++) {
+      double us = trace[i].duration_ns / 1000.0;
+      classes[commandClass(trace[i].cmd)].recorded.push_back(us);
+      recordedBusy += us;
+   }
+
+   map<string, long> outcomes; // reason -> count
+   int rotate = 0;
+   vector<iwScanCell> cells;
+   double replayedBusy = 0;
+   chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+   for (int pass = 0; pass < passes; pass++) {
+      chrono::steady_clock::time_point passStart = chrono::steady_clock::now();
+      backend->restart(passStart);
+      for (size_t i = 0; i < trace.size(); i++) {
+	 const iwTraceRecord & record = trace[i];
+	 if (mode == replayTimed) this_thread::sleep_until(passStart + chrono::nanoseconds(record.start_ns - backend->firstStart()));
+	 // Recover the interface exactly as the API spelled it (getWIFIList keeps a trailing
+	 // space) so the replayed call builds the very same command line.
+	 string program = record.cmd.substr(0, record.cmd.find(' '));
+	 string wifi, option;
+	 size_t raw = record.cmd.rfind(" --raw --");
+	 if (program == "iwgetid" && raw != string::npos && raw > 8) {
+	    wifi = record.cmd.substr(8, raw - 8);
+	    option = record.cmd.substr(raw + 7);
+	 }
+	 else if (program == "iwlist" && record.cmd.length() > 12) {
+	    wifi = record.cmd.substr(7, record.cmd.rfind(' ') - 7);
+	    option = record.cmd.substr(record.cmd.rfind(' ') + 1);
+	 }
+	 else if (program == "iwconfig" && record.cmd.length() > 9) {
+	    wifi = record.cmd.substr(9);
+	    size_t space = wifi.find(' ');
+	    if (space != string::npos && space + 1 < wifi.length()) option = "set"; // iwconfig <if> <param> <value>
+	 }
+	 iwStatus status;
+	 chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+	 if (record.cmd == "iwconfig") {
+	    status = wifiAPI.getWIFIList().empty() ? iwNotFound : iwOK;
+	 }
+	 else if (program == "iwconfig" && option.empty()) {
+	    switch (rotate++ % 7) {
+	       case 0: status = wifiAPI.tryGetESSID(wifi).status; break;
+	       case 1: status = wifiAPI.tryGetTX_Power(wifi).status; break;
+	       case 2: status = wifiAPI.tryGetSignalLevel(wifi).status; break;
+	       case 3: status = wifiAPI.tryGetBitRate(wifi).status; break;
+	       case 4: status = wifiAPI.tryGetRTS(wifi).status; break;
+	       case 5: status = wifiAPI.tryGetFrag(wifi).status; break;
+	       default: status = wifiAPI.tryGetRetry(wifi).status;
+	    }
+	 }
+	 else if (program == "iwgetid" && option == "--freq") status = wifiAPI.tryGetFrequency(wifi).status;
+	 else if (program == "iwgetid" && option == "--channel") status = wifiAPI.tryGetChannel(wifi).status;
+	 else if (program == "iwgetid" && option == "--mode") status = wifiAPI.tryGetMode(wifi).status;
+	 else if (program == "iwgetid" && option == "--ap") status = wifiAPI.tryGetAccessPoint(wifi).status;
+	 else if (program == "iwlist" && option == "scan") status = wifiAPI.tryScan(wifi, cells);
+	 else { // set commands carry no parsing, replay them as recorded
+	    string data;
+	    status = backend->run(record.cmd, data);
+	 }
+	 chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+	 double us = chrono::duration<double, micro>(t1 - t0).count();
+	 classes[commandClass(record.cmd)].replayed.push_back(us);
+	 replayedBusy += us;
+	 iwResult<int> outcome = {status, 0};
+	 outcomes[outcome.reason()]++;
+      }
+   }
+   double wall = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+   double operations = (double)trace.size() * passes;
+
+   printf("trace %s: %zu records, %d pass(es), %s\n", path.c_str(), trace.size(), passes,
+	  mode == replayTimed ? "timed" : "fast");
+   printf("%-32s %8s %10s %10s %10s %10s %10s %10s\n", "class", "count",
+	  "rec p50us", "rec p99us", "rec mean", "new p50us", "new p99us", "new mean");
+   for (map<string, latencies>::iterator it = classes.begin(); it != classes.end(); ++it) {
+      const latencies & l = it->second;
+      printf("%-32s %8zu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", it->first.c_str(), l.replayed.size(),
+	     percentile(l.recorded, 0.5), percentile(l.recorded, 0.99), mean(l.recorded),
+	     percentile(l.replayed, 0.5), percentile(l.replayed, 0.99), mean(l.replayed));
+   }
+   double recordedRate = recordedBusy > 0 ? trace.size() / (recordedBusy / 1e6) : 0;
+   double replayedRate = replayedBusy > 0 ? operations / (replayedBusy / 1e6) : 0;
+   printf("throughput (busy time): recorded %.1f ops/s, replayed %.1f ops/s", recordedRate, replayedRate);
+   if (recordedRate > 0) printf(" (%+.1f%%)", 100.0 * (replayedRate - recordedRate) / recordedRate);
+   printf("\nwall time: %.3f s for %.0f commands", wall, operations);
+   printf("\noutcomes:");
+   for (map<string, long>::iterator it = outcomes.begin(); it != outcomes.end(); ++it) {
+      printf(" %s=%ld", it->first.c_str(), it->second);
+   }
+   printf(" unmatched=%llu\n", (unsigned long long)backend->misses());
+   return 0;
+}
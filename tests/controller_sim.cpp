@@ -0,0 +1,125 @@
+/*****************************************************************************************
+* Title: 	controller_sim                                                           *
+* Purpose: 	Runs iwController against the simulator with a noiseless signal that     *
+*		follows the TX power dB for dB. Checks that the margin converges into the*
+*		dead band and then stays without further commands, that power steps are  *
+*		whole dB between 1 and the step limit (also for limits below 1 dB), that *
+*		the bit rate is lowered when TX power is exhausted and reaches the radio,*
+*		and that the simulator rejects a unit given as a separate word.          *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include "iwController.h"
+#include "iwSim.h"
+#include<iostream>
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const string & what){
+    if (!ok) {
+	cout << "FAILED: " << what << endl;
+	failures++;
+    }
+}
+
+// One radio whose signal is signal_mean at 20 dBm and moves 1 dB per dB of TX power.
+static shared_ptr<iwSimBackend> simulator(double signal_mean){
+    iwSimConfig config;
+    config.radios = 1;
+    config.signal_mean = signal_mean;
+    config.signal_sigma = 0;
+    config.signal_tau_s = 1e-6;
+    config.txpower_coupling = 1;
+    config.txpower_reference = 20;
+    return make_shared<iwSimBackend>(config);
+}
+
+// Steps the controller, returning false if any power step is 0 or larger than maxStep. The
+// step is measured on the radio, as the controller only learns the power in its first period.
+static bool stepChecked(iwconfigAPI & wifiAPI, iwController & controller, int periods, int maxStep,
+			iwControlState & state){
+    bool ok = true;
+    controller.getState("sim0", state);
+    for (int i = 0; i < periods; i++) {
+	int before = (int)wifiAPI.getTX_Power("sim0");
+	uint64_t changes = state.powerChanges;
+	controller.step();
+	controller.getState("sim0", state);
+	int step = abs(state.power_dbm - before);
+	if (state.powerChanges != changes && (step < 1 || step > maxStep)) ok = false;
+    }
+    return ok;
+}
+
+int main(){
+    iwControlState state;
+
+    // Convergence: 15 dB of margin at 20 dBm, lowered 2 dB at a time into the dead band.
+    {
+	iwconfigAPI wifiAPI(simulator(-50));
+	iwController controller(wifiAPI);
+	iwControlTarget target;
+	controller.setTarget("sim0", target);
+	check(stepChecked(wifiAPI, controller, 10, 2, state), "steps within the 2 dB limit");
+	check(state.status == iwOK && fabs(state.margin_db - target.margin_db) <= target.hysteresis_db,
+	      "margin converged, got " + to_string(state.margin_db));
+	check(wifiAPI.getTX_Power("sim0") == state.power_dbm, "radio runs at the commanded power");
+	uint64_t power = state.powerChanges, rate = state.rateChanges;
+	stepChecked(wifiAPI, controller, 30, 2, state);
+	check(state.powerChanges == power && state.rateChanges == rate, "no command once converged");
+    }
+
+    // A limit below 1 dB still moves 1 dB per period.
+    {
+	iwconfigAPI wifiAPI(simulator(-50));
+	iwController controller(wifiAPI);
+	iwControlTarget target;
+	target.max_step_db = 0.5;
+	controller.setTarget("sim0", target);
+	check(stepChecked(wifiAPI, controller, 10, 1, state), "1 dB steps with a 0.5 dB limit");
+	check(fabs(state.margin_db - target.margin_db) <= target.hysteresis_db, "converged with a 0.5 dB limit");
+    }
+
+    // A fractional limit rounds down: 10 dB short of the target at 5 dBm, raised at most 3 dB.
+    {
+	iwconfigAPI wifiAPI(simulator(-50));
+	check(wifiAPI.setTXPower("sim0", dBm, 5) == iwOK, "start at 5 dBm");
+	iwController controller(wifiAPI);
+	iwControlTarget target;
+	target.max_step_db = 3.7;
+	controller.setTarget("sim0", target);
+	check(stepChecked(wifiAPI, controller, 10, 3, state), "steps within a 3.7 dB limit");
+	check(fabs(state.margin_db - target.margin_db) <= target.hysteresis_db, "converged with a 3.7 dB limit");
+    }
+
+    // Out of TX power: the rate comes down to 6 Mb/s and the radio follows.
+    {
+	iwconfigAPI wifiAPI(simulator(-75));
+	iwController controller(wifiAPI);
+	iwControlTarget target;
+	target.rate_hold_ms = 0;
+	controller.setTarget("sim0", target);
+	stepChecked(wifiAPI, controller, 20, 2, state);
+	check(state.power_dbm == 20 && state.rate_mbps == 6, "rate lowered at full power, got "
+	      + to_string(state.rate_mbps));
+	check(wifiAPI.getBitRate("sim0") == 6, "radio runs at the commanded rate");
+    }
+
+    // iwconfig reads a unit word after the value as the next request.
+    {
+	shared_ptr<iwSimBackend> sim = simulator(-50);
+	string data;
+	sim->run("iwconfig sim0 rate 54 M", data);
+	check(data.find("Error") != string::npos, "separate unit word rejected");
+	sim->run("iwconfig sim0 rate 54x", data);
+	check(data.find("Error") != string::npos, "unknown unit rejected");
+	sim->run("iwconfig sim0 freq 2.412G", data);
+	check(data.empty(), "attached unit accepted");
+    }
+
+    cout << (failures ? "controller simulation tests failed" : "controller simulation tests passed") << endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+/*****************************************************************************************
+* Title: 	history                                                                  *
+* Purpose: 	Round trip of the Gorilla encoding of iwHistoryBlock and iwHistory.      *
+*		Timestamps step through both edges of every delta-of-delta bucket and the*
+*		32 bit escape; values cover an unchanged value, XORs whose leading zeros *
+*		exceed the 31 the header can store, a XOR spanning all 64 bits, reuse of *
+*		the previous XOR window and random bit patterns. Every decoded sample    *
+*		must match the appended one bit for bit.                                 *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include "iwHistory.h"
+#include<iostream>
+#include<random>
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const string & what){
+    if (!ok) {
+	cout << "FAILED: " << what << endl;
+	failures++;
+    }
+}
+
+static double fromBits(uint64_t bits){
+    double v;
+    memcpy(&v, &bits, sizeof v);
+    return v;
+}
+static uint64_t toBits(double v){
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    return bits;
+}
+
+// Appends the samples to fresh blocks, starting a new block whenever one is full, and
+// compares the decoded stream with what was appended.
+static void roundTrip(const vector<iwPoint> & samples, const string & what){
+    vector<unique_ptr<iwHistoryBlock>> blocks;
+    for (size_t i = 0; i < samples.size(); i++) {
+	if (blocks.empty() || !blocks.back()->append(samples[i].t_ms, samples[i].value)) {
+		blocks.emplace_back(new iwHistoryBlock());
+		blocks.back()->reset();
+		check(blocks.back()->append(samples[i].t_ms, samples[i].value), what + ": append to an empty block");
+	}
+    }
+    vector<iwPoint> decoded;
+    for (size_t b = 0; b < blocks.size(); b++)
+	blocks[b]->decode(INT64_MIN, INT64_MAX, [&decoded](int64_t t, double v) { decoded.push_back(iwPoint{t, v}); });
+    bool same = decoded.size() == samples.size();
+    for (size_t i = 0; same && i < samples.size(); i++)
+	same = decoded[i].t_ms == samples[i].t_ms && toBits(decoded[i].value) == toBits(samples[i].value);
+    check(same, what + ": decoded samples differ");
+}
+
+int main(){
+    // Delta of delta at both edges of each bucket: 1 bit, 7, 9 and 12 bit fields, 32 bit escape.
+    const int64_t dods[] = {0, -63, 64, -64, 65, -255, 256, -256, 257, -2047, 2048, -2048, 2049,
+			    INT32_MAX, INT32_MIN, 1, -1, 0};
+    vector<iwPoint> timestamps;
+    int64_t t = 1000000, delta = (int64_t)1 << 32;   // room for the negative steps
+    timestamps.push_back(iwPoint{t, 1.0});
+    for (size_t i = 0; i < sizeof dods / sizeof dods[0]; i++) {
+	delta += dods[i];
+	t += delta;
+	timestamps.push_back(iwPoint{t, 1.0});
+    }
+    roundTrip(timestamps, "delta of delta buckets");
+
+    // Values: unchanged, more than 31 leading zeros, a XOR of all 64 bits, a XOR inside the
+    // previous window, then a wider one.
+    const uint64_t values[] = {
+	0x3ff0000000000000ULL,   // 1.0
+	0x3ff0000000000000ULL,   // unchanged: one bit
+	0x3ff0000000000001ULL,   // XOR 1: 63 leading zeros, clamped to 31
+	0x3ff0000000000003ULL,   // XOR 2: fits the previous window
+	0xbff0000000000002ULL,   // XOR 0x8000000000000001: 64 meaningful bits
+	0x3ff0000000000003ULL,   // XOR 0x8000000000000001 again: window reused at full width
+	0x0000000000000001ULL,   // denormal
+	0x8000000000000000ULL,   // -0.0, XOR spans all 64 bits
+	0x7ff8000000000000ULL,   // NaN
+	0x7ff0000000000000ULL,   // infinity
+    };
+    vector<iwPoint> xors;
+    for (size_t i = 0; i < sizeof values / sizeof values[0]; i++) xors.push_back(iwPoint{(int64_t)i * 100, fromBits(values[i])});
+    roundTrip(xors, "value XORs");
+
+    // Random bit patterns and jittered timestamps over many blocks.
+    mt19937_64 rng(42);
+    vector<iwPoint> random;
+    t = 0;
+    for (int i = 0; i < 20000; i++) {
+	uint64_t bits = rng();
+	switch (i % 4) {
+	    case 0: break;                                                     // anything
+	    case 1: bits = toBits(random.back().value) ^ (bits & 0xff); break;  // low bits only
+	    case 2: bits = toBits(random.back().value); break;                 // unchanged
+	    default: bits = toBits(random.back().value) ^ (bits << 40);        // high bits only
+	}
+	t += 1 + (int64_t)(rng() % (i % 7 ? 200 : 50000));
+	random.push_back(iwPoint{t, fromBits(bits)});
+    }
+    roundTrip(random, "random samples");
+
+    // The same through iwHistory: quantized timestamps, windows across blocks, remove.
+    iwHistory history(10);
+    for (int i = 0; i < 5000; i++) history.append("wlan0", metricSignal, i * 100 + i % 7, -50 - (i % 13) * 0.5);
+    check(!history.append("wlan0", metricSignal, 0, 0), "out of order sample rejected");
+    vector<iwPoint> window;
+    check(history.query("wlan0", metricSignal, 100000, 200000, window) == 1000, "window query count");
+    bool same = !window.empty();
+    for (size_t i = 0; same && i < window.size(); i++) {
+	int k = 1000 + (int)i;
+	same = window[i].t_ms == k * 100 && window[i].value == -50 - (k % 13) * 0.5;
+    }
+    check(same, "window query values");
+    vector<iwBucket> buckets;
+    check(history.downsample("wlan0", metricSignal, 0, 500000, 100000, buckets) == 5 && buckets[0].count == 1000
+	  && buckets[0].min == -56 && buckets[0].max == -50, "downsample buckets");
+    history.remove("wlan0");
+    window.clear();
+    check(history.query("wlan0", metricSignal, 0, INT64_MAX, window) == 0 && history.usage().series == 0, "removed");
+
+    cout << (failures ? "history tests failed" : "history tests passed") << endl;
+    return failures ? 1 : 0;
+}
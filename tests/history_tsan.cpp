@@ -0,0 +1,62 @@
+/*****************************************************************************************
+* Title: 	history_tsan                                                             *
+* Purpose: 	Stress test of iwHistory, built with ThreadSanitizer. Appending and      *
+*		querying threads work on the series of a few adapters while another      *
+*		thread keeps removing those adapters, so series are dropped from the     *
+*		table while calls on them are in progress.                               *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include "iwHistory.h"
+#include<atomic>
+#include<iostream>
+#include<thread>
+
+using namespace std;
+
+int main(){
+    const int adapterCount = 4, appenders = 4, readers = 2, iterations = 20000;
+    iwHistory history;
+    history.setRetention(0, 4 * sizeof(iwHistoryBlock));
+    atomic<bool> stop(false);
+    atomic<uint64_t> stored(0), read(0), removed(0);
+
+    vector<thread> threads;
+    for (int w = 0; w < appenders; w++) {
+	threads.emplace_back([&, w] {
+	    for (int i = 0; i < iterations; i++) {
+		string wifi = "wlan" + to_string((w + i) % adapterCount);
+		if (history.append(wifi, (iwMetric)(i % 3), i, i % 17)) stored++;
+	    }
+	});
+    }
+    for (int r = 0; r < readers; r++) {
+	threads.emplace_back([&, r] {
+	    vector<iwPoint> points;
+	    vector<iwBucket> buckets;
+	    for (int i = 0; !stop; i++) {
+		string wifi = "wlan" + to_string((r + i) % adapterCount);
+		points.clear();
+		buckets.clear();
+		read += history.query(wifi, metricSignal, 0, INT64_MAX, points);
+		history.downsample(wifi, metricBitrate, 0, INT64_MAX, 1000, buckets);
+		if (i % 64 == 0) history.usage();
+	    }
+	});
+    }
+    thread remover([&] {
+	for (int i = 0; !stop; i++) {
+	    history.remove("wlan" + to_string(i % adapterCount));
+	    removed++;
+	    this_thread::yield();
+	}
+    });
+    for (int w = 0; w < appenders; w++) threads[w].join();
+    stop = true;
+    for (size_t i = appenders; i < threads.size(); i++) threads[i].join();
+    remover.join();
+
+    cout << "stored " << stored << ", read " << read << ", removals " << removed << endl;
+    return stored > 0 && removed > 0 ? 0 : 1;
+}
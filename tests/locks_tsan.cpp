@@ -0,0 +1,106 @@
+/*****************************************************************************************
+* Title: 	locks_tsan                                                               *
+* Purpose: 	Stress test of the per-adapter reader/writer locks, built with           *
+*		ThreadSanitizer. Readers and writers share one iwconfigAPI over several  *
+*		simulated radios and spell the adapters both as getWIFIList returns them *
+*		("sim0 ") and without the padding ("sim0"). A probe backend in front of  *
+*		the simulator counts the commands in flight per radio and fails the test *
+*		when a read overlaps a set of the same radio, or two sets overlap.       *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include "iwSim.h"
+#include<atomic>
+#include<iostream>
+#include<thread>
+
+using namespace std;
+
+static const int radioCount = 4;
+
+/*****************************************************************************************
+* Probe Backend: checks the fencing promised by iwconfigAPI on every command.           *
+*****************************************************************************************/
+class probeBackend : public iwBackend
+{
+   private:
+	shared_ptr<iwSimBackend> sim;
+	atomic<int> readers[radioCount];
+	atomic<int> writers[radioCount];
+
+   public:
+	atomic<uint64_t> reads, sets, violations;
+
+	explicit probeBackend(shared_ptr<iwSimBackend> simulated) : sim(simulated), reads(0), sets(0), violations(0) {
+	    for (int i = 0; i < radioCount; i++) {
+		readers[i] = 0;
+		writers[i] = 0;
+	    }
+	}
+	iwStatus run(const string & cmd, string & data) noexcept {
+	    istringstream words(cmd);
+	    string program, wifi, param;
+	    words >> program >> wifi >> param;
+	    int radio = wifi.length() > 3 ? atoi(wifi.c_str() + 3) : -1;
+	    if (radio < 0 || radio >= radioCount) return sim->run(cmd, data);
+	    bool set = program == "iwconfig" && !param.empty();
+	    if (set) {
+		if (writers[radio]++ != 0 || readers[radio] != 0) violations++;
+		sets++;
+	    }
+	    else {
+		readers[radio]++;
+		if (writers[radio] != 0) violations++;
+		reads++;
+	    }
+	    iwStatus status = sim->run(cmd, data);
+	    if (set) writers[radio]--;
+	    else readers[radio]--;
+	    return status;
+	}
+};
+
+int main(){
+    iwSimConfig config;
+    config.radios = radioCount;
+    config.latency_us = 50;
+    config.jitter_us = 50;
+    shared_ptr<iwSimBackend> sim = make_shared<iwSimBackend>(config);
+    shared_ptr<probeBackend> probe = make_shared<probeBackend>(sim);
+    iwconfigAPI wifiAPI(probe);
+
+    const int readerThreads = 8, writerThreads = 4, iterations = 300;
+    vector<thread> threads;
+    for (int t = 0; t < readerThreads; t++) {
+	threads.emplace_back([&wifiAPI, t] {
+	    iwSnapshot snap;
+	    for (int i = 0; i < iterations; i++) {
+		string wifi = "sim" + to_string((t + i) % radioCount) + (i % 2 ? " " : "");
+		switch (i % 4) {
+		    case 0: wifiAPI.tryGetSignalLevel(wifi); break;
+		    case 1: wifiAPI.tryGetSnapshot(wifi, snap); break;
+		    case 2: wifiAPI.getChannel(wifi); break;
+		    default: wifiAPI.tryGetFrequency(wifi);
+		}
+	    }
+	});
+    }
+    for (int t = 0; t < writerThreads; t++) {
+	threads.emplace_back([&wifiAPI, t] {
+	    for (int i = 0; i < iterations / 2; i++) {
+		string wifi = "sim" + to_string((t + i) % radioCount) + (i % 2 ? "" : " ");
+		switch (i % 3) {
+		    case 0: wifiAPI.setChannel(wifi, 1 + 5 * (i % 3)); break;
+		    case 1: wifiAPI.setTXPower(wifi, dBm, 10 + i % 10); break;
+		    default: wifiAPI.setFrequency(wifi, 2.412 + 0.005 * (i % 10), GHz);
+		}
+	    }
+	});
+    }
+    for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+
+    cout << "reads " << probe->reads << ", sets " << probe->sets << ", overlapping commands "
+	 << probe->violations << endl;
+    return probe->violations == 0 && probe->reads > 0 && probe->sets > 0 ? 0 : 1;
+}
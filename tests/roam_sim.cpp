@@ -0,0 +1,75 @@
+/*****************************************************************************************
+* Title: 	roam_sim                                                                 *
+* Purpose: 	Roams a simulated radio between two access points with iwRoamAssistant   *
+*		and the simulator's link events. A candidate seen within the validation  *
+*		age is used from the cache, an older one is confirmed by a scan first,   *
+*		and one that scan no longer reports ends the roam with roamNoCandidate   *
+*		without touching the link. Also checks that asking for the candidates of *
+*		an unknown interface does not add it.                                    *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include "iwRoam.h"
+#include "iwSim.h"
+#include<iostream>
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool ok, const string & what){
+    if (!ok) {
+	cout << "FAILED: " << what << endl;
+	failures++;
+    }
+}
+
+static const string apA = "02:AA:00:00:00:01", apB = "02:AA:00:00:00:02";
+
+int main(){
+    iwSimConfig config;
+    config.radios = 1;
+    config.signal_sigma = 0;
+    config.signal_tau_s = 1e-3;
+    config.assoc_ms = 10;
+    shared_ptr<iwSimBackend> sim = make_shared<iwSimBackend>(config);
+    iwconfigAPI wifiAPI(sim);
+    sim->addAccessPoint(apA, "campus", 1, -60);
+    sim->addAccessPoint(apB, "campus", 6, -70);
+
+    iwRoamPolicy policy;
+    policy.validate_ms = 100;
+    iwRoamAssistant roam(wifiAPI, sim.get(), policy);
+
+    check(roam.candidates("wlan7").empty() && roam.interfaces().empty(), "unknown interface not added");
+
+    // Join A, then roam to B while its scan is fresh: no validation scan.
+    check(roam.roam("sim0", apA).outcome == roamDone, "joined A");
+    check(roam.scan("sim0") == iwOK && roam.candidates("sim0").size() == 2, "both access points cached");
+    iwRoamRecord r = roam.roam("sim0");
+    check(r.outcome == roamDone && r.to == apB && !r.validated, "fresh candidate used from the cache");
+    check(wifiAPI.tryGetAccessPoint("sim0").value == apB, "radio on B");
+
+    // Back on A with a cache older than the validation age: B is confirmed by a scan.
+    check(roam.roam("sim0", apA).outcome == roamDone, "back on A");
+    this_thread::sleep_for(chrono::milliseconds(150));
+    uint64_t scans = roam.getStatistics().scans;
+    r = roam.roam("sim0");
+    check(r.outcome == roamDone && r.to == apB && r.validated, "stale candidate validated, got "
+	  + string(iwRoamReason(r.outcome)));
+    check(roam.getStatistics().scans == scans + 1, "one validation scan");
+
+    // B disappears after the last scan: the validation scan drops it and the link stays on A.
+    check(roam.roam("sim0", apA).outcome == roamDone, "on A again");
+    check(roam.scan("sim0") == iwOK, "scan with B present");
+    sim->removeAccessPoint(apB);
+    this_thread::sleep_for(chrono::milliseconds(150));
+    r = roam.roam("sim0");
+    check(r.outcome == roamNoCandidate && r.validated, "vanished candidate not used, got "
+	  + string(iwRoamReason(r.outcome)));
+    check(wifiAPI.tryGetAccessPoint("sim0").value == apA, "radio still on A");
+
+    cout << (failures ? "roam simulation tests failed" : "roam simulation tests passed") << endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,62 @@
+/*****************************************************************************************
+* Title: 	scheduler_tsan                                                           *
+* Purpose: 	Stress test of iwScheduler, built with ThreadSanitizer. One thread runs  *
+*		the scheduler at a 1 ms tick over simulated radios while other threads   *
+*		keep adding, removing and notifying adapters, so the adapter and entry   *
+*		tables grow and are reused while snapshot fetches are in flight.         *
+*****************************************************************************************/
+/*****************************************************************************************
+* Include Files                                                                          *
+*****************************************************************************************/
+#include "iwScheduler.h"
+#include "iwSim.h"
+#include<atomic>
+#include<iostream>
+#include<thread>
+
+using namespace std;
+
+int main(){
+    const int radioCount = 64;
+    iwSimConfig config;
+    config.radios = radioCount;
+    config.latency_us = 100;
+    config.jitter_us = 100;
+    iwconfigAPI wifiAPI(make_shared<iwSimBackend>(config));
+
+    atomic<uint64_t> delivered(0);
+    iwScheduler scheduler(wifiAPI, [&delivered](const string & wifi, iwMetric, const iwSnapshot &) {
+	if (!wifi.empty()) delivered++;
+    }, chrono::milliseconds(1));
+    iwPollPolicy fast = {1, 1, 4, 1};
+    for (int m = 0; m < metricCount; m++) scheduler.setDefaultPolicy((iwMetric)m, fast);
+
+    atomic<bool> stop(false);
+    thread driver([&scheduler, &stop] { scheduler.run(stop); });
+
+    const int churnThreads = 4, rounds = 400;
+    vector<thread> churn;
+    for (int t = 0; t < churnThreads; t++) {
+	churn.emplace_back([&scheduler, t] {
+	    for (int i = 0; i < rounds; i++) {
+		string wifi = "sim" + to_string((t * rounds + i) % radioCount);
+		switch (i % 4) {
+		    case 0: scheduler.add(wifi, vector<iwMetric>{metricSignal, metricBitrate}); break;
+		    case 1: scheduler.notify(wifi, metricSignal, 2); break;
+		    case 2: scheduler.interval(wifi, metricBitrate); break;
+		    default: scheduler.remove(wifi);
+		}
+		if (i % 16 == 0) this_thread::sleep_for(chrono::microseconds(500));
+	    }
+	});
+    }
+    for (size_t i = 0; i < churn.size(); i++) churn[i].join();
+    this_thread::sleep_for(chrono::milliseconds(20));
+    stop = true;
+    driver.join();
+
+    iwScheduler::statistics stats = scheduler.getStatistics();
+    cout << "ticks " << stats.ticks << ", fetches " << stats.fetches << ", samples " << stats.samples
+	 << ", delivered " << delivered << endl;
+    return stats.fetches > 0 && delivered > 0 ? 0 : 1;
+}